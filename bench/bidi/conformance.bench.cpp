@@ -0,0 +1,107 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <numeric>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/conformance.hpp"
+#include "jcu/ucd/data_file.hpp"
+
+
+namespace {
+
+
+/* Value at fraction p of sorted, nearest rank. */
+uint64_t Percentile(const std::vector<uint64_t>& sorted, double p) {
+    if (sorted.empty()) { return 0; }
+    size_t rank = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+
+/* Resolve every case of suite and print pass/fail, throughput and the distribution of time per case. */
+bool Report(std::string_view name, const jcu::bidi::BidiConformance& suite, size_t threads, size_t repeats) {
+    jcu::bidi::BidiConformanceResult result = suite.Resolve(threads, repeats);
+
+    std::vector<uint64_t> sorted = result.nanoseconds;
+    std::ranges::sort(sorted);
+    uint64_t total_ns = std::accumulate(sorted.begin(), sorted.end(), uint64_t{0});
+    double seconds = static_cast<double>(total_ns) / 1e9;
+    double wall_ms = std::chrono::duration<double, std::milli>(result.elapsed).count();
+    size_t failures = result.Failures();
+
+    std::println("{:<20} cases {:>8}  failed {:>6}  threads {:>3}  wall {:>9.1f} ms", name, suite.cases.size(),
+                 failures, result.threads, wall_ms);
+    std::println("{:<20} {:>10.0f} cases/s  {:>8.2f} Mcp/s  (one thread, fastest of {})", "",
+                 seconds ? static_cast<double>(suite.cases.size()) / seconds : 0.0,
+                 seconds ? static_cast<double>(suite.text.size()) / seconds / 1e6 : 0.0, repeats);
+    std::println("{:<20} ns/case  p50 {:>8}  p90 {:>8}  p99 {:>8}  max {:>8}", "", Percentile(sorted, 0.50),
+                 Percentile(sorted, 0.90), Percentile(sorted, 0.99), sorted.empty() ? 0 : sorted.back());
+
+    for (size_t index = 0, shown = 0; index < suite.cases.size() && shown < 10; ++index) {
+        if (result.passed[index]) { continue; }
+        ++shown;
+        std::println("{:<20} line {} failed{}{}", "", suite.cases[index].line_num,
+                     result.errors[index].empty() ? "" : ": ", result.errors[index]);
+    }
+    return failures == 0;
+}
+
+
+void PrintHelp() {
+    std::println("Usage: bidi_conformancebench [data directory] [--threads N] [--repeats N] [--seed N]");
+    std::println("Resolves every case of BidiTest.txt and BidiCharacterTest.txt (default directory ../data),");
+    std::println("checks the levels and reports throughput and percentiles of the time per case.  Exits with 1 on");
+    std::println("any failure so it can serve as a regression check as well as a benchmark.");
+}
+
+
+}
+
+
+int main(int argc, char** argv) {
+    std::filesystem::path directory = std::filesystem::path{".."} / "data";
+    size_t threads = 0;
+    size_t repeats = 5;
+    uint32_t seed = 1;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-h" || arg == "--help") { PrintHelp(); return 0; }
+            if ((arg == "--threads" || arg == "--repeats" || arg == "--seed") && i + 1 < argc) {
+                std::string_view value{argv[++i]};
+                if (arg == "--threads") { threads = jcu::ucd::ParseInteger<size_t>(value); }
+                else if (arg == "--repeats") { repeats = jcu::ucd::ParseInteger<size_t>(value); }
+                else { seed = jcu::ucd::ParseInteger<uint32_t>(value); }
+            } else if (!arg.starts_with("-")) {
+                directory = arg;
+            } else {
+                PrintHelp();
+                return 1;
+            }
+        }
+
+        auto load_start = std::chrono::steady_clock::now();
+        auto bidi_test = jcu::bidi::BidiConformance::FromBidiTest(directory, seed);
+        auto bidi_character_test = jcu::bidi::BidiConformance::FromBidiCharacterTest(directory);
+        std::chrono::duration<double, std::milli> load_ms = std::chrono::steady_clock::now() - load_start;
+        std::println("Loaded {} cases in {:.1f} ms", bidi_test.cases.size() + bidi_character_test.cases.size(),
+                     load_ms.count());
+
+        bool passed = Report("BidiTest", bidi_test, threads, repeats);
+        passed = Report("BidiCharacterTest", bidi_character_test, threads, repeats) && passed;
+        return passed ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::println("Error: {}", e.what());
+        return 1;
+    }
+}
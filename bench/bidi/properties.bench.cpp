@@ -0,0 +1,298 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/conformance.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/classify.hpp"
+#include "jcu/data/bidi_brackets.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/data/derived_general_category.hpp"
+#include "jcu/data/scripts.hpp"
+#include "jcu/ucd/data_file.hpp"
+#include "harness.hpp"
+
+
+namespace {
+
+
+using jcu::bench::Result;
+
+
+struct CodePointRange {
+    char32_t first;
+    char32_t last;
+};
+
+
+/* Code points of one writing system, for the property lookups. */
+struct LookupCorpus {
+    std::string_view name;
+    std::vector<CodePointRange> ranges;
+};
+
+
+const std::vector<LookupCorpus> LOOKUP_CORPORA{
+    {"ascii",    {{0x20, 0x7E}}},
+    {"latin",    {{0x20, 0x7E}, {0xC0, 0x17F}}},
+    {"hebrew",   {{0x5D0, 0x5EA}, {0x20, 0x20}, {0x591, 0x5C7}}},
+    {"arabic",   {{0x621, 0x64A}, {0x20, 0x20}, {0x660, 0x669}}},
+    {"cjk",      {{0x4E00, 0x9FFF}, {0x3000, 0x3002}}},
+    {"emoji",    {{0x1F300, 0x1F64F}, {0x1F900, 0x1F9FF}, {0x200D, 0x200D}}},
+    {"mixed",    {{0x20, 0x7E}, {0x5D0, 0x5EA}, {0x621, 0x64A}, {0x4E00, 0x9FFF}, {0x1F300, 0x1F64F},
+                  {0x28, 0x29}, {0x2018, 0x201D}}},
+};
+
+
+std::u32string MakeLookupText(const LookupCorpus& corpus, size_t length, std::mt19937& generator) {
+    std::uniform_int_distribution<size_t> pick_range{0, corpus.ranges.size() - 1};
+    std::u32string text{};
+    text.reserve(length);
+    for (size_t i = 0; i < length; ++i) {
+        const CodePointRange& range = corpus.ranges[pick_range(generator)];
+        std::uniform_int_distribution<uint32_t> pick{range.first, range.last};
+        text.push_back(static_cast<char32_t>(pick(generator)));
+    }
+    return text;
+}
+
+
+/***
+ * Paragraphs of words with a controlled share of right-to-left words, explicit embeddings and isolates nested up to
+ * depth, a share of words wrapped in brackets, and a paragraph length in code points.
+ */
+struct BidiCorpus {
+    std::string_view name;
+    double rtl_ratio;
+    size_t depth;
+    double bracket_density;
+    size_t paragraph_length;
+};
+
+
+const std::vector<BidiCorpus> BIDI_CORPORA{
+    {"ltr short",             0.00, 0, 0.00,    40},
+    {"rtl short",             1.00, 0, 0.00,    40},
+    {"mixed short",           0.50, 0, 0.10,    40},
+    {"mixed paragraph",       0.30, 0, 0.05,  1000},
+    {"mixed long",            0.30, 0, 0.05, 60000},
+    {"brackets dense",        0.50, 0, 0.50,  1000},
+    {"nested depth 4",        0.50, 4, 0.10,  1000},
+    {"nested depth 60",       0.50, 60, 0.10, 1000},
+    {"nested long depth 60",  0.50, 60, 0.10, 60000},
+};
+
+
+std::u32string MakeParagraph(const BidiCorpus& corpus, std::mt19937& generator) {
+    constexpr std::array<char32_t, 4> OPENERS{0x202A, 0x202B, 0x2066, 0x2067};    // LRE RLE LRI RLI
+    constexpr std::array<std::pair<char32_t, char32_t>, 3> BRACKETS{{{'(', ')'}, {'[', ']'}, {'{', '}'}}};
+
+    std::bernoulli_distribution rtl{corpus.rtl_ratio};
+    std::bernoulli_distribution bracket{corpus.bracket_density};
+    std::bernoulli_distribution nest{corpus.depth ? 0.2 : 0.0};
+    std::uniform_int_distribution<size_t> word_length{2, 8};
+    std::uniform_int_distribution<size_t> pick_opener{0, OPENERS.size() - 1};
+    std::uniform_int_distribution<size_t> pick_bracket{0, BRACKETS.size() - 1};
+    std::uniform_int_distribution<uint32_t> latin{'a', 'z'};
+    std::uniform_int_distribution<uint32_t> hebrew{0x5D0, 0x5EA};
+    std::uniform_int_distribution<uint32_t> digit{'0', '9'};
+
+    std::u32string text{};
+    std::vector<char32_t> closers{};
+    while (text.size() < corpus.paragraph_length) {
+        if (nest(generator)) {
+            if (closers.size() < corpus.depth && (closers.empty() || generator() % 2)) {
+                char32_t opener = OPENERS[pick_opener(generator)];
+                text.push_back(opener);
+                closers.push_back(opener >= 0x2066 ? char32_t{0x2069} : char32_t{0x202C});     // PDI or PDF
+            } else if (!closers.empty()) {
+                text.push_back(closers.back());
+                closers.pop_back();
+            }
+        }
+
+        bool is_bracket = bracket(generator);
+        auto [open, close] = BRACKETS[pick_bracket(generator)];
+        if (is_bracket) { text.push_back(open); }
+        bool is_rtl = rtl(generator);
+        for (size_t i = word_length(generator); i; --i) {
+            text.push_back(static_cast<char32_t>(is_rtl ? hebrew(generator) : latin(generator)));
+        }
+        if (generator() % 8 == 0) { text.push_back(static_cast<char32_t>(digit(generator))); }
+        if (is_bracket) { text.push_back(close); }
+        text.push_back(' ');
+    }
+    while (!closers.empty()) {
+        text.push_back(closers.back());
+        closers.pop_back();
+    }
+    return text;
+}
+
+
+/* Enough paragraphs of corpus for about target code points. */
+std::vector<std::u32string> MakeParagraphs(const BidiCorpus& corpus, size_t target, std::mt19937& generator) {
+    std::vector<std::u32string> paragraphs{};
+    size_t total = 0;
+    do {
+        paragraphs.push_back(MakeParagraph(corpus, generator));
+        total += paragraphs.back().size();
+    } while (total < target);
+    return paragraphs;
+}
+
+
+void PrintResult(const Result& result) {
+    const jcu::bench::Measurement& m = result.measurement;
+    std::println("{:<20} {:<30} {:>9.3f} ns/cp {:>10.1f} ns/call {:>8.2f} allocs/call {:>10.0f} B/call{}",
+                 result.group, result.name, result.NanosecondsPerCodePoint(), m.NanosecondsPerCall(),
+                 m.AllocationsPerCall(), m.AllocatedBytesPerCall(),
+                 jcu::bench::FormatCounters(m, result.bytes, result.code_points));
+}
+
+
+void BenchLookups(std::vector<Result>& results, size_t length, size_t repeats, std::mt19937& generator) {
+    for (const LookupCorpus& corpus : LOOKUP_CORPORA) {
+        std::u32string text = MakeLookupText(corpus, length, generator);
+        std::string group = std::format("lookup {}", corpus.name);
+        auto Add = [&](std::string_view name, auto&& lookup) {
+            Result result{.group=group, .name=std::string{name}, .bytes=text.size() * sizeof(char32_t),
+                          .code_points=text.size()};
+            result.measurement = jcu::bench::Measure(repeats, text.size(), [&](size_t index) {
+                return static_cast<uint64_t>(lookup(text[index]));
+            });
+            results.push_back(std::move(result));
+        };
+
+        Add("DerivedBidiClass::Lookup", jcu::data::DerivedBidiClass::Lookup);
+        Add("DerivedGeneralCategory::Lookup", jcu::data::DerivedGeneralCategory::Lookup);
+        Add("Scripts::Lookup", jcu::data::Scripts::Lookup);
+        Add("BidiBrackets::Lookup", [](char32_t code_point) {
+            return jcu::data::BidiBrackets::Lookup(code_point).pair_id;
+        });
+
+        // The cached range lookup used by Classify, for comparison with the table search.
+        jcu::detail::RangeLookup<jcu::data::DerivedBidiClass> bidi_lookup{};
+        Add("RangeLookup<DerivedBidiClass>", [&bidi_lookup](char32_t code_point) { return bidi_lookup(code_point); });
+    }
+}
+
+
+/* ToRuns and AppendRuns with a reused workspace over every paragraph; one call per paragraph. */
+void BenchRuns(std::vector<Result>& results, std::string_view group, std::span<const std::u32string> paragraphs,
+               size_t repeats) {
+    uint64_t code_points = 0;
+    for (const std::u32string& paragraph : paragraphs) { code_points += paragraph.size(); }
+
+    Result to_runs{.group=std::string{group}, .name="ToRuns", .bytes=code_points * sizeof(char32_t),
+                   .code_points=code_points};
+    to_runs.measurement = jcu::bench::Measure(repeats, paragraphs.size(), [&](size_t index) {
+        return jcu::bidi::ToRuns(paragraphs[index]).size();
+    });
+    results.push_back(std::move(to_runs));
+
+    jcu::bidi::BidiWorkspace<> workspace{};
+    std::vector<jcu::bidi::Run> runs{};
+    Result append_runs{.group=std::string{group}, .name="AppendRuns (reused workspace)",
+                       .bytes=code_points * sizeof(char32_t), .code_points=code_points};
+    append_runs.measurement = jcu::bench::Measure(repeats, paragraphs.size(), [&](size_t index) {
+        runs.clear();
+        return jcu::bidi::AppendRuns(workspace, paragraphs[index], jcu::bidi::LEVEL_TYPE_DEFAULT_AUTO, runs);
+    });
+    results.push_back(std::move(append_runs));
+}
+
+
+void PrintHelp() {
+    std::println("Usage: bidi_propertiesbench [data directory] [--length N] [--repeats N] [--seed N] [--json FILE]");
+    std::println("                            [--counters]");
+    std::println("Measures the property table lookups over code points of several scripts, and ToRuns over");
+    std::println("synthetic paragraphs of controlled RTL ratio, nesting depth, bracket density and length and over");
+    std::println("the texts of BidiCharacterTest.txt when found in the data directory (default ../data).  Reports ns");
+    std::println("per code point and allocations per call.  --json writes the results ('-' for stdout).");
+    std::println("--counters adds hardware counters (Linux perf_event_open) per byte and per code point.");
+}
+
+
+}
+
+
+int main(int argc, char** argv) {
+    std::filesystem::path directory = std::filesystem::path{".."} / "data";
+    size_t length = 1 << 20;
+    size_t repeats = 5;
+    uint32_t seed = 1;
+    std::string json_path{};
+    bool counters = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-h" || arg == "--help") { PrintHelp(); return 0; }
+            if (!arg.starts_with("-")) { directory = arg; continue; }
+            if (arg == "--counters") { counters = true; continue; }
+            if (i + 1 >= argc) { PrintHelp(); return 1; }
+            std::string_view value{argv[++i]};
+            if (arg == "--length") { length = jcu::ucd::ParseInteger<size_t>(value); }
+            else if (arg == "--repeats") { repeats = jcu::ucd::ParseInteger<size_t>(value); }
+            else if (arg == "--seed") { seed = jcu::ucd::ParseInteger<uint32_t>(value); }
+            else if (arg == "--json") { json_path = value; }
+            else { PrintHelp(); return 1; }
+        }
+
+        if (counters) { jcu::bench::EnableCounters(); }
+
+        std::mt19937 generator{seed};
+        std::vector<Result> results{};
+        BenchLookups(results, length, repeats, generator);
+
+        for (const BidiCorpus& corpus : BIDI_CORPORA) {
+            std::vector<std::u32string> paragraphs = MakeParagraphs(corpus, length / 4, generator);
+            BenchRuns(results, corpus.name, paragraphs, repeats);
+        }
+
+        if (std::filesystem::exists(directory / jcu::ucd::BidiCharacterTestForwardView::FILE_NAME)) {
+            auto suite = jcu::bidi::BidiConformance::FromBidiCharacterTest(directory);
+            std::vector<std::u32string> samples{};
+            for (const auto& test : suite.cases) {
+                auto text = suite.Text(test);
+                samples.emplace_back(text.begin(), text.end());
+            }
+            BenchRuns(results, "BidiCharacterTest", samples, repeats);
+        } else {
+            std::println("BidiCharacterTest.txt not found in {}; skipped", directory.generic_string());
+        }
+
+        if (json_path != "-") { std::ranges::for_each(results, PrintResult); }
+        if (json_path == "-") {
+            std::ostringstream out{};
+            jcu::bench::WriteJson(out, results);
+            std::print("{}", out.str());
+        } else if (!json_path.empty()) {
+            std::ofstream out{json_path, std::ios::out | std::ios::trunc};
+            jcu::bench::WriteJson(out, results);
+            if (!out) { throw std::runtime_error{std::format("Failed to write: {}", json_path)}; }
+        }
+    } catch (const std::exception& e) {
+        std::println("Error: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <print>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+
+
+namespace {
+
+
+/* The former L2 implementation: every level from max_level down to 1 rescans all of the runs. */
+void NaiveReorderRuns(std::vector<jcu::bidi::Run>& runs, jcu::bidi::BidiLevel max_level) {
+    for (jcu::bidi::BidiLevel newLevel = max_level; newLevel; newLevel--) {
+        size_t start = runs.size();
+        while (start--) {
+            if (runs[start].level >= newLevel) {
+                size_t count = 1;
+                for (; start && runs[start - 1].level >= newLevel; start--) {
+                    count += 1;
+                }
+                std::ranges::reverse(std::span{runs.begin() + start, count});
+            }
+        }
+    }
+}
+
+
+/* Runs climbing to the maximum embedding level and back down, repeated; the worst case for the naive version. */
+std::vector<jcu::bidi::Run> MakeNestedRuns(size_t repeats, jcu::bidi::BidiLevel depth) {
+    std::vector<jcu::bidi::Run> runs{};
+    size_t offset = 0;
+    for (size_t r = 0; r < repeats; ++r) {
+        for (jcu::bidi::BidiLevel level = 0; level <= depth; ++level) {
+            runs.push_back({.offset=offset++, .length=1, .level=level});
+        }
+        for (jcu::bidi::BidiLevel level = depth; level-- > 0;) {
+            runs.push_back({.offset=offset++, .length=1, .level=level});
+        }
+    }
+    return runs;
+}
+
+
+template <typename F>
+double Measure(size_t iterations, F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) { f(); }
+    std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / static_cast<double>(iterations);
+}
+
+
+void Compare(std::string_view name, const std::vector<jcu::bidi::Run>& source, size_t iterations) {
+    jcu::bidi::BidiLevel max_level = std::ranges::max(source, {}, &jcu::bidi::Run::level).level;
+
+    std::vector<jcu::bidi::Run> naive = source;
+    std::vector<jcu::bidi::Run> fast = source;
+    NaiveReorderRuns(naive, max_level);
+    jcu::bidi::ReorderRuns(fast);
+    bool same = std::ranges::equal(naive, fast, [](const auto& lhs, const auto& rhs) {
+        return lhs.offset == rhs.offset && lhs.length == rhs.length && lhs.level == rhs.level;
+    });
+
+    std::vector<jcu::bidi::Run> runs{};
+    double naive_us = Measure(iterations, [&]() { runs = source; NaiveReorderRuns(runs, max_level); });
+    double fast_us = Measure(iterations, [&]() { runs = source; jcu::bidi::ReorderRuns(runs); });
+
+    std::println("{:<24} runs {:>8}  naive {:>10.2f} us  reorder {:>10.2f} us  speedup {:>6.1f}x  {}",
+                 name, source.size(), naive_us, fast_us, naive_us / fast_us, same ? "match" : "MISMATCH");
+}
+
+
+}
+
+
+int main() {
+    Compare("nested depth 125", MakeNestedRuns(64, jcu::bidi::LEVEL_TYPE_MAX), 200);
+    Compare("nested depth 16", MakeNestedRuns(512, 16), 200);
+    Compare("alternating 0/1", MakeNestedRuns(8192, 1), 200);
+
+    std::vector<jcu::bidi::Run> sparse{};
+    for (size_t i = 0; i < 16384; ++i) {
+        sparse.push_back({.offset=i, .length=1, .level=static_cast<jcu::bidi::BidiLevel>(i % 2 ? 120 : 2)});
+    }
+    Compare("two deep levels", sparse, 200);
+
+    return 0;
+}
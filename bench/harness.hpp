@@ -0,0 +1,309 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <ostream>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "jcu/allocation.hpp"
+
+
+/***
+ * Shared measurement code of the benchmarks.  Each benchmark is a single translation unit, so this header also
+ * installs the allocation tracking of jcu/allocation.hpp to count the allocations of the measured code; include it in
+ * exactly one translation unit of an executable.
+ */
+namespace jcu::bench {
+
+
+/* Hardware events counted around each measured region when counters are enabled. */
+enum class Counter : size_t { CYCLES, INSTRUCTIONS, L1D_MISSES, LLC_MISSES, BRANCH_MISSES, COUNT };
+
+
+inline constexpr size_t COUNTER_COUNT = static_cast<size_t>(Counter::COUNT);
+inline constexpr std::array<std::string_view, COUNTER_COUNT> COUNTER_NAMES{
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"};
+
+
+/* Counter values of one region; a counter the system could not provide is not valid and reads as 0. */
+struct Counts {
+    std::array<uint64_t, COUNTER_COUNT> values{};
+    std::array<bool, COUNTER_COUNT> valid{};
+
+    bool Any() const { return std::ranges::find(valid, true) != valid.end(); }
+    bool Valid(Counter counter) const { return valid[static_cast<size_t>(counter)]; }
+    uint64_t operator[](Counter counter) const { return values[static_cast<size_t>(counter)]; }
+};
+
+
+/***
+ * User space hardware counters of the calling thread read through perf_event_open.  Each event is opened on its own
+ * so that a machine, VM or kernel setting (perf_event_paranoid) that lacks some of them still provides the rest; when
+ * the kernel multiplexes the events their values are scaled by the fraction of the region they were counting.  Why
+ * names the first event that could not be opened; on other systems, or when none can be, Available is false.
+ */
+class PerfCounters {
+#if defined(__linux__)
+    std::array<int, COUNTER_COUNT> fds{};
+#endif
+    std::string why{};
+
+public:
+    PerfCounters() {
+#if defined(__linux__)
+        constexpr auto CACHE_READ_MISS = [](uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        constexpr std::array<std::array<uint64_t, 2>, COUNTER_COUNT> EVENTS{{
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        }};
+
+        for (size_t index = 0; index < COUNTER_COUNT; ++index) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = static_cast<uint32_t>(EVENTS[index][0]);
+            attr.config = EVENTS[index][1];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[index] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds[index] < 0 && why.empty()) {
+                why = std::format("perf_event_open({}): {}", COUNTER_NAMES[index], std::strerror(errno));
+            }
+        }
+#else
+        why = "hardware counters are only read on Linux";
+#endif
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds) { if (fd >= 0) { close(fd); } }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool Available() const {
+#if defined(__linux__)
+        return std::ranges::any_of(fds, [](int fd) { return fd >= 0; });
+#else
+        return false;
+#endif
+    }
+
+    const std::string& Why() const { return why; }
+
+    void Start() {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd < 0) { continue; }
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    Counts Stop() {
+        Counts counts{};
+#if defined(__linux__)
+        for (int fd : fds) { if (fd >= 0) { ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); } }
+        for (size_t index = 0; index < COUNTER_COUNT; ++index) {
+            std::array<uint64_t, 3> data{};  // value, time enabled, time running
+            if (fds[index] < 0 || read(fds[index], data.data(), sizeof(data)) != sizeof(data) || !data[2]) {
+                continue;
+            }
+            double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+            counts.values[index] = static_cast<uint64_t>(static_cast<double>(data[0]) * scale);
+            counts.valid[index] = true;
+        }
+#endif
+        return counts;
+    }
+};
+
+
+namespace detail {
+
+
+inline PerfCounters* counters = nullptr;
+
+
+}
+
+
+/***
+ * Count hardware events around every following Measure.  Counters that cannot be opened are reported on stderr, so
+ * that JSON on stdout stays valid, and left out of the measurements; with none the benchmark only times.
+ */
+inline const PerfCounters& EnableCounters() {
+    static PerfCounters counters{};
+    if (!counters.Available()) {
+        std::println(stderr, "Hardware counters unavailable, timing only: {}", counters.Why());
+    } else if (!counters.Why().empty()) {
+        std::println(stderr, "Some hardware counters unavailable: {}", counters.Why());
+    }
+    detail::counters = counters.Available() ? &counters : nullptr;
+    return counters;
+}
+
+
+/* Keeps the result of measured code observable so that the work is not optimized away. */
+inline volatile uint64_t sink = 0;
+
+
+struct Measurement {
+    uint64_t nanoseconds{0};            //< Fastest repeat.
+    uint64_t calls{0};                  //< Calls per repeat.
+    AllocationCounts allocations{};     //< Of the last repeat, made by the calling thread.
+    Counts counters{};                  //< Of the fastest repeat; only with EnableCounters.
+
+    double NanosecondsPerCall() const { return calls ? static_cast<double>(nanoseconds) / calls : 0; }
+    double AllocationsPerCall() const { return calls ? static_cast<double>(allocations.count) / calls : 0; }
+    double AllocatedBytesPerCall() const { return calls ? static_cast<double>(allocations.bytes) / calls : 0; }
+};
+
+
+/***
+ * Call func(index) for index in [0, calls), repeats times, and keep the fastest repeat.  func returns a value that is
+ * folded into sink.  The first repeat doubles as the warm-up of caches and reused buffers.
+ */
+template <typename Func_t>
+Measurement Measure(size_t repeats, size_t calls, Func_t&& func) {
+    Measurement measurement{.nanoseconds=std::numeric_limits<uint64_t>::max(), .calls=calls};
+    for (size_t repeat = 0; repeat < std::max<size_t>(1, repeats); ++repeat) {
+        uint64_t sum = 0;
+        AllocationScope allocations{};
+        if (detail::counters) { detail::counters->Start(); }
+        auto start = std::chrono::steady_clock::now();
+        for (size_t index = 0; index < calls; ++index) { sum += static_cast<uint64_t>(func(index)); }
+        std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+        Counts counts = detail::counters ? detail::counters->Stop() : Counts{};
+        AllocationCounts allocated = allocations.Counts();
+
+        sink = sink + sum;
+        if (static_cast<uint64_t>(elapsed.count()) < measurement.nanoseconds) {
+            measurement.nanoseconds = static_cast<uint64_t>(elapsed.count());
+            measurement.counters = counts;
+        }
+        measurement.allocations = allocated;
+    }
+    return measurement;
+}
+
+
+/* Ratio of count to amount, or 0 when the counter is missing or amount is 0. */
+inline double CountPer(const Counts& counts, Counter counter, uint64_t amount) {
+    return counts.Valid(counter) && amount ? static_cast<double>(counts[counter]) / static_cast<double>(amount) : 0;
+}
+
+
+/***
+ * Counter columns of a table row for input of bytes and code_points: instructions per cycle, cycles per byte and
+ * per code point and misses per thousand code points.  Empty when the measurement has no counts.
+ */
+inline std::string FormatCounters(const Measurement& m, uint64_t bytes, uint64_t code_points) {
+    const Counts& c = m.counters;
+    if (!c.Any()) { return {}; }
+    auto Column = [&c](bool valid, double value, std::string_view unit) {
+        return valid ? std::format(" {:>7.3f} {}", value, unit) : std::format(" {:>7} {}", "-", unit);
+    };
+    bool cycles = c.Valid(Counter::CYCLES);
+    return Column(cycles && c.Valid(Counter::INSTRUCTIONS), CountPer(c, Counter::INSTRUCTIONS, c[Counter::CYCLES]),
+                  "IPC") +
+           Column(cycles, CountPer(c, Counter::CYCLES, bytes), "cyc/B") +
+           Column(cycles, CountPer(c, Counter::CYCLES, code_points), "cyc/cp") +
+           Column(c.Valid(Counter::L1D_MISSES), 1000 * CountPer(c, Counter::L1D_MISSES, code_points), "L1D") +
+           Column(c.Valid(Counter::LLC_MISSES), 1000 * CountPer(c, Counter::LLC_MISSES, code_points), "LLC") +
+           Column(c.Valid(Counter::BRANCH_MISSES), 1000 * CountPer(c, Counter::BRANCH_MISSES, code_points),
+                  "br misses/kcp");
+}
+
+
+/***
+ * JSON members, with a leading ", ", for the counts of a measurement and their ratios per byte and per code point;
+ * empty when the measurement has no counts.  Missing counters are null.
+ */
+inline std::string CountersJson(const Measurement& m, uint64_t bytes, uint64_t code_points) {
+    const Counts& c = m.counters;
+    if (!c.Any()) { return {}; }
+    std::string json = ", \"counters\": {";
+    for (size_t index = 0; index < COUNTER_COUNT; ++index) {
+        Counter counter = static_cast<Counter>(index);
+        if (!c.Valid(counter)) {
+            json += std::format("{}\"{}\": null", index ? ", " : "", COUNTER_NAMES[index]);
+            continue;
+        }
+        json += std::format("{}\"{}\": {}, \"{}_per_byte\": {:.6f}, \"{}_per_code_point\": {:.6f}",
+                            index ? ", " : "", COUNTER_NAMES[index], c[counter], COUNTER_NAMES[index],
+                            CountPer(c, counter, bytes), COUNTER_NAMES[index], CountPer(c, counter, code_points));
+    }
+    return json + "}";
+}
+
+
+/* One row of a benchmark: what was measured, over how much input, and the measurement. */
+struct Result {
+    std::string group{};
+    std::string name{};
+    uint64_t bytes{0};          //< Input per repeat.
+    uint64_t code_points{0};    //< Input per repeat.
+    Measurement measurement{};
+
+    double NanosecondsPerCodePoint() const {
+        return code_points ? static_cast<double>(measurement.nanoseconds) / code_points : 0;
+    }
+    double GBPerSecond() const {
+        return measurement.nanoseconds ? static_cast<double>(bytes) / measurement.nanoseconds : 0;
+    }
+};
+
+
+/* Results as a JSON document for comparing runs across commits. */
+inline void WriteJson(std::ostream& out, const std::vector<Result>& results) {
+    out << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        const Measurement& m = r.measurement;
+        out << std::format("    {{\"group\": \"{}\", \"name\": \"{}\", \"bytes\": {}, \"code_points\": {}, "
+                           "\"calls\": {}, \"ns\": {}, \"ns_per_code_point\": {:.4f}, "
+                           "\"allocations_per_call\": {:.3f}, \"allocated_bytes_per_call\": {:.1f}{}}}{}\n",
+                           r.group, r.name, r.bytes, r.code_points, m.calls, m.nanoseconds,
+                           r.NanosecondsPerCodePoint(), m.AllocationsPerCall(), m.AllocatedBytesPerCall(),
+                           CountersJson(m, r.bytes, r.code_points), i + 1 < results.size() ? "," : "");
+    }
+    out << "  ]\n}\n";
+}
+
+
+}
+
+
+JCU_INSTALL_ALLOCATION_TRACKING();
@@ -0,0 +1,328 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <ostream>
+#include <print>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jcu/ucd/data_file.hpp"
+#include "jcu/utf/utf.hpp"
+#include "harness.hpp"
+
+
+namespace {
+
+
+struct CodePointRange {
+    char32_t first;
+    char32_t last;
+    uint32_t weight;
+};
+
+
+/* Code points drawn by weight from ranges typical of a kind of text. */
+struct CorpusKind {
+    std::string_view name;
+    std::vector<CodePointRange> ranges;
+};
+
+
+const std::vector<CorpusKind> CORPUS_KINDS{
+    {"ascii",    {{0x20, 0x7E, 95}, {0x0A, 0x0A, 2}}},
+    {"latin",    {{0x20, 0x7E, 80}, {0xC0, 0x17F, 20}}},
+    {"cyrillic", {{0x410, 0x44F, 80}, {0x20, 0x20, 15}, {0x2C, 0x2E, 5}}},
+    {"cjk",      {{0x4E00, 0x9FFF, 90}, {0x3000, 0x3002, 5}, {0x30, 0x39, 5}}},
+    {"emoji",    {{0x1F300, 0x1F64F, 40}, {0x1F900, 0x1F9FF, 30}, {0x200D, 0x200D, 10}, {0x20, 0x20, 20}}},
+    {"mixed",    {{0x20, 0x7E, 40}, {0xC0, 0x17F, 10}, {0x410, 0x44F, 10}, {0x5D0, 0x5EA, 10},
+                  {0x4E00, 0x9FFF, 15}, {0x1F300, 0x1F64F, 10}, {0x10000, 0x1000F, 5}}},
+};
+
+
+/* The same text in every encoding; corrupted corpora damage each encoding independently. */
+struct Corpus {
+    std::string name{};
+    bool valid{true};
+    std::u32string code_points{};
+    std::u8string utf8{};
+    std::u16string utf16{};
+    std::u32string utf32{};
+};
+
+
+/* Deterministic text of kind with about target_bytes of UTF-8. */
+std::u32string MakeText(const CorpusKind& kind, size_t target_bytes, std::mt19937& generator) {
+    std::vector<uint32_t> weights{};
+    for (const CodePointRange& range : kind.ranges) { weights.push_back(range.weight); }
+    std::discrete_distribution<size_t> pick_range{weights.begin(), weights.end()};
+
+    std::u32string text{};
+    size_t bytes = 0;
+    while (bytes < target_bytes) {
+        const CodePointRange& range = kind.ranges[pick_range(generator)];
+        std::uniform_int_distribution<uint32_t> pick{range.first, range.last};
+        char32_t code_point = static_cast<char32_t>(pick(generator));
+        text.push_back(code_point);
+        bytes += jcu::utf::SequenceLength8(code_point);
+    }
+    return text;
+}
+
+
+/* Replace about one code unit in a thousand with one that cannot appear there in well-formed text. */
+template <typename String_t>
+void Corrupt(String_t& text, std::mt19937& generator) {
+    using Value_t = typename String_t::value_type;
+    constexpr std::array<char32_t, 3> BAD_UTF8{0xFF, 0x80, 0xC0};
+    constexpr std::array<char32_t, 2> BAD_UTF16{0xD800, 0xDC00};
+    constexpr std::array<char32_t, 2> BAD_UTF32{0xD800, 0x110000};
+
+    std::uniform_int_distribution<size_t> pick_bad{0, 1};
+    std::bernoulli_distribution damage{0.001};
+    for (Value_t& unit : text) {
+        if (!damage(generator)) { continue; }
+        size_t bad = pick_bad(generator);
+        if constexpr (sizeof(Value_t) == 1) { unit = static_cast<Value_t>(BAD_UTF8[bad + (unit & 1)]); }
+        else if constexpr (sizeof(Value_t) == 2) { unit = static_cast<Value_t>(BAD_UTF16[bad]); }
+        else { unit = static_cast<Value_t>(BAD_UTF32[bad]); }
+    }
+}
+
+
+std::vector<Corpus> MakeCorpora(size_t target_bytes, uint32_t seed) {
+    std::vector<Corpus> corpora{};
+    std::mt19937 generator{seed};
+    for (const CorpusKind& kind : CORPUS_KINDS) {
+        Corpus corpus{.name=std::string{kind.name}, .code_points=MakeText(kind, target_bytes, generator)};
+        for (char32_t code_point : corpus.code_points) {
+            corpus.utf8.append_range(jcu::utf::EncodeUTF8(code_point));
+            corpus.utf16.append_range(jcu::utf::EncodeUTF16(code_point));
+        }
+        corpus.utf32 = corpus.code_points;
+
+        Corpus corrupted = corpus;
+        corrupted.valid = false;
+        Corrupt(corrupted.utf8, generator);
+        Corrupt(corrupted.utf16, generator);
+        Corrupt(corrupted.utf32, generator);
+
+        corpora.push_back(std::move(corpus));
+        corpora.push_back(std::move(corrupted));
+    }
+    return corpora;
+}
+
+
+struct Result {
+    std::string corpus{};
+    bool valid{true};
+    std::string_view encoding{};
+    std::string_view api{};
+    size_t bytes{0};
+    size_t code_points{0};
+    jcu::bench::Measurement measurement{};
+
+    double GBPerSecond() const {
+        uint64_t ns = measurement.nanoseconds;
+        return ns ? static_cast<double>(bytes) / static_cast<double>(ns) : 0;
+    }
+    double CodePointsPerSecond() const {
+        uint64_t ns = measurement.nanoseconds;
+        return ns ? static_cast<double>(code_points) * 1e9 / static_cast<double>(ns) : 0;
+    }
+};
+
+
+/* One API applied to one input; stop_at_error APIs are only measured on valid text where they read all of it. */
+struct Api {
+    std::string_view name;
+    std::function<uint64_t()> func;
+    bool stop_at_error{false};
+};
+
+
+/* Every public API that reads text, applied to one encoding of a corpus. */
+template <typename String_t>
+std::vector<Api> Apis(const String_t& text) {
+    return {
+        {"Decode", [&text]() {
+            uint64_t sum = 0;
+            for (auto it = text.begin(); it != text.end();) {
+                auto data = jcu::utf::Decode(it, text.end());
+                sum += data.code_point;
+                it = data.next;
+            }
+            return sum;
+        }},
+        {"CodePointView", [&text]() {
+            uint64_t sum = 0;
+            for (char32_t code_point : jcu::utf::CodePointView{text}) { sum += code_point; }
+            return sum;
+        }},
+        {"DecodeDataView", [&text]() {
+            uint64_t sum = 0;
+            for (const auto& data : jcu::utf::DecodeDataView{text}) { sum += static_cast<uint64_t>(data.error_code); }
+            return sum;
+        }},
+        {"IsValid", [&text]() { return uint64_t{jcu::utf::IsValid(text)}; }, true},
+        {"FindFirstInvalid", [&text]() {
+            return static_cast<uint64_t>(std::ranges::distance(text.begin(), jcu::utf::FindFirstInvalid(text)));
+        }, true},
+        {"AttemptConvertToUTF32", [&text]() {
+            std::u32string out{};
+            jcu::utf::AttemptConvertToUTF(text, out);
+            return uint64_t{out.size()};
+        }, true},
+        {"ConvertToUTF8", [&text]() { return uint64_t{jcu::utf::ConvertToUTF8(text).size()}; }},
+        {"ConvertToUTF16", [&text]() { return uint64_t{jcu::utf::ConvertToUTF16(text).size()}; }},
+        {"ConvertToUTF32", [&text]() { return uint64_t{jcu::utf::ConvertToUTF32(text).size()}; }},
+    };
+}
+
+
+/* Encoding code points one at a time, appended as the converters do. */
+std::vector<Api> EncodeApis(const std::u32string& code_points) {
+    return {
+        {"EncodeUTF8", [&code_points]() {
+            std::u8string out{};
+            std::ranges::copy(code_points, jcu::utf::CodePointAppender(out));
+            return uint64_t{out.size()};
+        }},
+        {"EncodeUTF16", [&code_points]() {
+            std::u16string out{};
+            std::ranges::copy(code_points, jcu::utf::CodePointAppender(out));
+            return uint64_t{out.size()};
+        }},
+        {"EncodeUTF32", [&code_points]() {
+            std::u32string out{};
+            std::ranges::copy(code_points, jcu::utf::CodePointAppender(out));
+            return uint64_t{out.size()};
+        }},
+    };
+}
+
+
+void WriteJson(std::ostream& out, const std::vector<Result>& results, size_t target_bytes, size_t repeats,
+               uint32_t seed) {
+    out << std::format("{{\n  \"bytes_per_corpus\": {},\n  \"repeats\": {},\n  \"seed\": {},\n  \"results\": [\n",
+                       target_bytes, repeats, seed);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << std::format("    {{\"corpus\": \"{}\", \"valid\": {}, \"encoding\": \"{}\", \"api\": \"{}\", "
+                           "\"bytes\": {}, \"code_points\": {}, \"ns\": {}, \"gb_per_s\": {:.4f}, "
+                           "\"code_points_per_s\": {:.0f}{}}}{}\n",
+                           r.corpus, r.valid, r.encoding, r.api, r.bytes, r.code_points, r.measurement.nanoseconds,
+                           r.GBPerSecond(), r.CodePointsPerSecond(),
+                           jcu::bench::CountersJson(r.measurement, r.bytes, r.code_points),
+                           i + 1 < results.size() ? "," : "");
+    }
+    out << "  ]\n}\n";
+}
+
+
+void PrintHelp() {
+    std::println("Usage: utf_throughputbench [--size BYTES] [--repeats N] [--seed N] [--filter TEXT] [--json FILE]");
+    std::println("                           [--counters]");
+    std::println("Measures every UTF API on generated ascii, latin, cyrillic, cjk, emoji and mixed text, valid and");
+    std::println("corrupted, in UTF-8, UTF-16 and UTF-32.  --filter keeps measurements whose corpus, encoding or api");
+    std::println("contains TEXT.  --json writes the results for comparison across commits ('-' for stdout).");
+    std::println("--counters adds hardware counters (Linux perf_event_open) per byte and per code point.");
+}
+
+
+}
+
+
+int main(int argc, char** argv) {
+    size_t target_bytes = 1 << 20;
+    size_t repeats = 5;
+    uint32_t seed = 1;
+    std::string filter{};
+    std::string json_path{};
+    bool counters = false;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string_view arg{argv[i]};
+            if (arg == "-h" || arg == "--help") { PrintHelp(); return 0; }
+            if (arg == "--counters") { counters = true; continue; }
+            if (i + 1 >= argc) { PrintHelp(); return 1; }
+            std::string_view value{argv[++i]};
+            if (arg == "--size") { target_bytes = jcu::ucd::ParseInteger<size_t>(value); }
+            else if (arg == "--repeats") { repeats = std::max<size_t>(1, jcu::ucd::ParseInteger<size_t>(value)); }
+            else if (arg == "--seed") { seed = jcu::ucd::ParseInteger<uint32_t>(value); }
+            else if (arg == "--filter") { filter = value; }
+            else if (arg == "--json") { json_path = value; }
+            else { PrintHelp(); return 1; }
+        }
+
+        if (counters) { jcu::bench::EnableCounters(); }
+        std::vector<Corpus> corpora = MakeCorpora(target_bytes, seed);
+        std::vector<Result> results{};
+        bool quiet = json_path == "-";
+
+        auto Run = [&](const Corpus& corpus, std::string_view encoding, size_t bytes, auto&& apis) {
+            size_t code_points = 0;
+            if (encoding == "UTF-8") {
+                code_points = static_cast<size_t>(std::ranges::distance(jcu::utf::CodePointView{corpus.utf8}));
+            } else if (encoding == "UTF-16") {
+                code_points = static_cast<size_t>(std::ranges::distance(jcu::utf::CodePointView{corpus.utf16}));
+            } else {
+                code_points = corpus.utf32.size();
+            }
+
+            for (const Api& api : apis) {
+                if (api.stop_at_error && !corpus.valid) { continue; }
+                auto Matches = [&](std::string_view s) { return s.find(filter) != std::string_view::npos; };
+                if (!filter.empty() && !Matches(corpus.name) && !Matches(encoding) && !Matches(api.name)) { continue; }
+
+                Result result{.corpus=corpus.name, .valid=corpus.valid, .encoding=encoding, .api=api.name,
+                              .bytes=bytes, .code_points=code_points};
+                result.measurement = jcu::bench::Measure(repeats, 1, [&api](size_t) { return api.func(); });
+                if (!quiet) {
+                    std::println("{:<9} {:<9} {:<10} {:<22} {:>8.3f} GB/s {:>9.1f} Mcp/s{}", result.corpus,
+                                 result.valid ? "valid" : "corrupted", result.encoding, result.api,
+                                 result.GBPerSecond(), result.CodePointsPerSecond() / 1e6,
+                                 jcu::bench::FormatCounters(result.measurement, bytes, code_points));
+                }
+                results.push_back(std::move(result));
+            }
+        };
+
+        for (const Corpus& corpus : corpora) {
+            Run(corpus, "UTF-8", corpus.utf8.size(), Apis(corpus.utf8));
+            Run(corpus, "UTF-16", corpus.utf16.size() * 2, Apis(corpus.utf16));
+            Run(corpus, "UTF-32", corpus.utf32.size() * 4, Apis(corpus.utf32));
+            if (corpus.valid) {
+                Run(corpus, "code point", corpus.code_points.size() * 4, EncodeApis(corpus.code_points));
+            }
+        }
+
+        if (quiet) {
+            std::ostringstream out{};
+            WriteJson(out, results, target_bytes, repeats, seed);
+            std::print("{}", out.str());
+        } else if (!json_path.empty()) {
+            std::ofstream out{json_path, std::ios::out | std::ios::trunc};
+            WriteJson(out, results, target_bytes, repeats, seed);
+            if (!out) { throw std::runtime_error{std::format("Failed to write: {}", json_path)}; }
+        }
+    } catch (const std::exception& e) {
+        std::println("Error: {}", e.what());
+        return 1;
+    }
+    return 0;
+}
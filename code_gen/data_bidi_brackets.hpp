@@ -5,7 +5,9 @@
 
 #include <filesystem>
 #include <format>
-#include <fstream>
+#include <map>
+#include <ostream>
+#include <stdexcept>
 #include <string_view>
 #include <utility>
 
@@ -21,7 +23,26 @@ std::filesystem::path Path(const jcu::ucd::BidiBrackets&, const std::filesystem:
 }
 
 
-void WriteHeader(std::ofstream& out, const jcu::ucd::BidiBrackets& data) {
+void WriteHeader(std::ostream& out, const jcu::ucd::BidiBrackets& data) {
+    /*
+     * Pair IDs are numbered from 1 by opening bracket.  U+2329 and U+232A are canonically equivalent to U+3008 and
+     * U+3009 (BD16) and share their ID, so pairing compares IDs only.
+     */
+    static const std::map<char32_t, char32_t> CANONICAL{{0x2329, 0x3008}, {0x232A, 0x3009}};
+    auto Canonical_f = [](char32_t code_point) {
+        auto it = CANONICAL.find(code_point);
+        return it == CANONICAL.end() ? code_point : it->second;
+    };
+    auto Opening_f = [&Canonical_f](const auto& entry) {
+        bool is_open = entry.second.bracket_paired_type == jcu::ucd::BracketPairedType::OPEN;
+        return Canonical_f(is_open ? entry.first : entry.second.paired_code_point);
+    };
+    std::map<char32_t, size_t> pair_ids{};
+    for (const auto& entry : data) { pair_ids.emplace(Opening_f(entry), 0); }
+    size_t pair_id = 0;
+    for (auto& [opening, id] : pair_ids) { id = ++pair_id; }
+    if (pair_id >= 0x80) { throw std::runtime_error("Bracket pair IDs do not fit a BidiBracketTag"); }
+
     out <<
 R"(/*
  * Automatically generated by code_gen/bidi_bracket_data.hpp
@@ -51,13 +72,34 @@ enum class BracketPairedType : uint8_t {
 struct BidiBracketsUnit {
     char32_t paired_code_point{0};
     BracketPairedType bracket_paired_type{BracketPairedType::NONE};
+    uint8_t pair_id{0};     //< Shared by both brackets of a pair and by canonically equivalent pairs; 0 for none.
 };
 
 
+/***
+ * A bracket in one byte for per code unit arrays: the pair ID shifted left once with the low bit set for a closing
+ * bracket.  0 is not a bracket.
+ */
+using BidiBracketTag = uint8_t;
+
+
+constexpr BidiBracketTag MakeBidiBracketTag(const BidiBracketsUnit& unit) noexcept {
+    if (unit.bracket_paired_type == BracketPairedType::NONE) { return 0; }
+    return static_cast<BidiBracketTag>((unit.pair_id << 1) | (unit.bracket_paired_type == BracketPairedType::CLOSE));
+}
+constexpr uint8_t BidiBracketTagPairId(BidiBracketTag tag) noexcept { return tag >> 1; }
+constexpr bool IsBidiBracketTagOpen(BidiBracketTag tag) noexcept { return tag && !(tag & 1); }
+constexpr bool IsBidiBracketTagClose(BidiBracketTag tag) noexcept { return tag & 1; }
+
+
 class BidiBrackets {
 public:
     using value_type = BidiBracketsUnit;
 
+)";
+    out << std::format("    static constexpr uint8_t PAIR_ID_MAX = {};\n", pair_id);
+    out <<
+R"(
     static constexpr auto begin() noexcept { return data.cbegin(); }
     static constexpr auto end() noexcept { return data.cend(); }
 
@@ -93,10 +135,12 @@ private:
     };
     for (; it != it_end; ++it) {
         out << std::format("        Data{{.code_point={:#x}, "
-                           ".value={{.paired_code_point={:#x}, .bracket_paired_type=BracketPairedType::{}}}}}{}\n",
+                           ".value={{.paired_code_point={:#x}, .bracket_paired_type=BracketPairedType::{}, "
+                           ".pair_id={}}}}}{}\n",
             it->first,
             it->second.paired_code_point,
             Convert_f(it->second.bracket_paired_type),
+            pair_ids.at(Opening_f(*it)),
             (it == it_last ? "" : ","));
     }
 
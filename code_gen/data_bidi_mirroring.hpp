@@ -5,7 +5,7 @@
 
 #include <filesystem>
 #include <format>
-#include <fstream>
+#include <ostream>
 #include <string_view>
 #include <utility>
 
@@ -21,7 +21,7 @@ std::filesystem::path Path(const jcu::ucd::BidiMirroring&, const std::filesystem
 }
 
 
-void WriteHeader(std::ofstream& out, const jcu::ucd::BidiMirroring& data) {
+void WriteHeader(std::ostream& out, const jcu::ucd::BidiMirroring& data) {
     out <<
 R"(/*
  * Automatically generated by code_gen/bidi_mirroring_data.hpp
@@ -35,6 +35,7 @@ R"(/*
 #include <array>
 #include <limits>
 
+#include "jcu/perfect_hash.hpp"
 #include "jcu/unicode_version.hpp"
 
 
@@ -49,9 +50,9 @@ public:
     static constexpr auto end() noexcept { return data.cend(); }
 
     static constexpr value_type Lookup(char32_t code_point) noexcept {
-        auto it = std::ranges::lower_bound(data, code_point, {}, &Data::code_point);
-        if (it == data.end() || it->code_point != code_point) { return std::numeric_limits<char32_t>::max(); }
-        return it->value;
+        uint16_t index = hash.Find(code_point);
+        if (index == hash.NONE || data[index].code_point != code_point) { return std::numeric_limits<char32_t>::max(); }
+        return data[index].value;
     }
 
     static constexpr const UnicodeVersion &Version() noexcept { return version; }
@@ -78,9 +79,12 @@ private:
                            it->first, it->second, (it == it_last ? "" : ","));
     }
 
+    out << "    }};\n";
+    out << std::format("    static constexpr PerfectHash<{}> hash{{data, &Data::code_point}};\n",
+                       std::ranges::distance(data.begin(), data.end()));
+
     out <<
-R"(    }};
-};
+R"(};
 
 
 }
@@ -5,7 +5,7 @@
 
 #include <filesystem>
 #include <format>
-#include <fstream>
+#include <ostream>
 #include <string_view>
 
 #include "jcu/strings/bidi_type.hpp"
@@ -21,7 +21,7 @@ std::filesystem::path Path(const jcu::ucd::DerivedBidiClass&, const std::filesys
 }
 
 
-void WriteHeader(std::ofstream& out, const jcu::ucd::DerivedBidiClass& data) {
+void WriteHeader(std::ostream& out, const jcu::ucd::DerivedBidiClass& data) {
     out <<
 R"(/*
  * Automatically generated by code_gen/bidi_type_data.hpp
@@ -7,7 +7,7 @@
 #include <cctype>
 #include <filesystem>
 #include <format>
-#include <fstream>
+#include <ostream>
 #include <string_view>
 #include <utility>
 
@@ -24,7 +24,7 @@ std::filesystem::path Path(const jcu::ucd::DerivedGeneralCategory&, const std::f
 }
 
 
-void WriteHeader(std::ofstream& out, const jcu::ucd::DerivedGeneralCategory& data) {
+void WriteHeader(std::ostream& out, const jcu::ucd::DerivedGeneralCategory& data) {
     out <<
 R"(/*
  * Automatically generated by code_gen/general_category_data.hpp
@@ -5,7 +5,7 @@
 
 #include <filesystem>
 #include <format>
-#include <fstream>
+#include <ostream>
 #include <string_view>
 #include <utility>
 
@@ -22,7 +22,7 @@ std::filesystem::path Path(const jcu::ucd::Scripts&, const std::filesystem::path
 }
 
 
-void WriteHeader(std::ofstream& out, const jcu::ucd::Scripts& data) {
+void WriteHeader(std::ostream& out, const jcu::ucd::Scripts& data) {
     out <<
 R"(/*
  * Automatically generated by code_gen/script_data.hpp
@@ -1,21 +1,27 @@
 // Copyright © 2015-2021 Muhammad Tayyab Akram
 
 #include <algorithm>
+#include <cstdint>
 #include <exception>
 #include <filesystem>
+#include <format>
+#include <functional>
 #include <print>
-#include <map>
 #include <ranges>
+#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#include "jcu/parallel.hpp"
 #include "jcu/ucd/bidi_brackets.hpp"
 #include "jcu/ucd/bidi_mirroring.hpp"
 #include "jcu/ucd/derived_bidi_class.hpp"
 #include "jcu/ucd/derived_general_category.hpp"
 #include "jcu/ucd/scripts.hpp"
+#include "jcu/ucd/utility.hpp"
 
 #include "jcu/utf/format.hpp"
 
@@ -24,6 +30,7 @@
 #include "data_bidi_mirroring.hpp"
 #include "data_derived_general_category.hpp"
 #include "data_scripts.hpp"
+#include "output.hpp"
 
 
 using namespace jcu;
@@ -31,32 +38,91 @@ using namespace jcu::code_gen;
 using namespace jcu::ucd;
 
 
-std::map<std::string_view, int> targets{
-    {"BidiBrackets", 0},
-    {"BidiMirroring", 0},
-    {"DerivedBidiClass", 0},
-    {"GeneralCategory", 0},
-    {"Scripts", 0}
+// Recorded in the manifest so that targets are regenerated when it changes; bump it whenever a change to code_gen
+// (e.g. to the data_*.hpp generators) changes the generated headers.
+constexpr std::string_view GENERATOR_VERSION{"1"};
+
+
+struct Generated {
+    std::filesystem::path path{};
+    std::string content{};
+};
+
+
+struct Target {
+    std::string_view name;
+    std::vector<std::string_view> inputs;   //< Data files read; the first one carries the UCD version.
+    std::function<Generated(const std::filesystem::path&, const std::filesystem::path&)> generate;
+};
+
+
+template <typename Data_t>
+Generated Generate(const std::filesystem::path& data_path, const std::filesystem::path& include_path) {
+    Data_t data{data_path};
+    std::ostringstream out{};
+    WriteHeader(out, data);
+    return {.path=Path(data, include_path), .content=std::move(out).str()};
+}
+
+
+std::vector<Target> targets{
+    {"BidiBrackets", {BidiBrackets::FILE_NAME}, Generate<BidiBrackets>},
+    {"BidiMirroring", {BidiMirroring::FILE_NAME}, Generate<BidiMirroring>},
+    {"DerivedBidiClass", {DerivedBidiClass::FILE_NAME}, Generate<DerivedBidiClass>},
+    {"GeneralCategory", {DerivedGeneralCategory::FILE_NAME}, Generate<DerivedGeneralCategory>},
+    {"Scripts", {Scripts::FILE_NAME}, Generate<Scripts>}
 };
 
 
 void PrintHelp() {
     std::println("Help:");
-    std::println("gen_code [--root {{src_root}}] [{{targets}}...]");
+    std::println("gen_code [--root {{src_root}}] [--force] [{{targets}}...]");
     std::println("    root_src- Optional path to the repo root.");
+    std::println("    force-    Parse every target even if its inputs are unchanged.");
     std::println("    targets-");
-    for (auto [k, v] : targets) {
-        std::println("        {}", k);
+    for (const Target& target : targets) {
+        std::println("        {}", target.name);
     }
 }
 
 
+/***
+ * Bring the header of target up to date and return what was done.  Hashing the inputs is far cheaper than parsing
+ * them, so an entry of the manifest that matches them and the header on disk skips the target entirely; otherwise the
+ * header is generated in memory and only replaces the one on disk if it differs.
+ */
+std::string_view Update(const Target& target,
+                        const std::filesystem::path& data_path,
+                        const std::filesystem::path& include_path,
+                        const Manifest::Entry* last,
+                        Manifest::Entry& entry,
+                        bool force) {
+    UnicodeVersion version = ExtractVersion(data_path / target.inputs.front());
+    entry.generator = std::string{GENERATOR_VERSION};
+    entry.version = std::format("{}.{}.{}", version.major, version.minor, version.micro);
+    for (std::string_view input : target.inputs) {
+        entry.inputs.emplace_back(std::string{input}, HashFile(data_path / input));
+    }
+
+    if (!force && last && last->SameInputs(entry) && HashFile(last->output) == last->output_hash) {
+        entry = *last;
+        return "up to date";
+    }
+
+    Generated generated = target.generate(data_path, include_path);
+    entry.output = generated.path;
+    entry.output_hash = HashBytes(generated.content);
+    return WriteIfChanged(generated.path, generated.content) ? "done" : "unchanged";
+}
+
+
 int main(int argc, const char** argv) {
     std::vector<std::string_view> args{argv, argv + argc};
     std::filesystem::path data_path{"data"};
     std::filesystem::path include_path{"include"};
     std::filesystem::path test_path{"tests"};
     size_t start_target_index = 1;
+    bool force = false;
 
     if (args.size() >= 3) {
         if (args[1] == std::string_view{"--root"}) {
@@ -68,10 +134,13 @@ int main(int argc, const char** argv) {
         }
     }
 
+    std::vector<bool> selected(targets.size(), false);
     for (auto i : args | std::views::drop(start_target_index)) {
         if (i == "--help" || i == "help" || i == "/?" || i == "-help") { PrintHelp(); return 0; }
-        else if (auto it = targets.find(i); it != targets.end()) { targets[i] = 1; }
-        else {
+        else if (i == "--force") { force = true; }
+        else if (auto it = std::ranges::find(targets, i, &Target::name); it != targets.end()) {
+            selected[static_cast<size_t>(it - targets.begin())] = true;
+        } else {
             std::println("Invalid target: {}\n", i);
             PrintHelp();
             return 1;
@@ -79,33 +148,43 @@ int main(int argc, const char** argv) {
     }
 
     // If no target was chosen, choose them all.
-    if (auto it = std::ranges::find_if(targets, [](auto&& pair) { return pair.second == 1; }); it == targets.end()) {
-        for (auto& [k, target] : targets) { target = 1; }
+    if (std::ranges::find(selected, true) == selected.end()) { selected.assign(targets.size(), true); }
+
+    std::vector<size_t> chosen{};
+    for (size_t index = 0; index < targets.size(); ++index) {
+        if (selected[index]) { chosen.push_back(index); }
     }
 
-    // TODO: Research more if mapping to object construction is possible from string or related identifier.
-    auto Write = [&](const auto& obj, const auto& dst_path) {
-        std::ofstream out{jcu::code_gen::Path(obj, dst_path), std::ios::out | std::ios::trunc};
-        jcu::code_gen::WriteHeader(out, obj);
-    };
-    for (auto [k, target] : targets) {
-        if (!target) { continue; }
-        std::print("Generating {} ... ", k);
+    // Targets read different files and write different headers so they are generated concurrently; the manifest is
+    // only read before and written after.
+    std::filesystem::path manifest_path = data_path / Manifest::FILE_NAME;
+    Manifest manifest{manifest_path};
+    std::vector<Manifest::Entry> entries(chosen.size());
+    std::vector<std::string> results(chosen.size());
+    std::vector<uint8_t> failed(chosen.size(), 0);
+    ParallelFor(chosen.size(), chosen.size(), [&](size_t, size_t index) {
+        const Target& target = targets[chosen[index]];
         try {
-            if      (k == "BidiBrackets")     { Write(BidiBrackets{data_path}, include_path); }
-            else if (k == "BidiMirroring")   { Write(BidiMirroring{data_path}, include_path); }
-            else if (k == "DerivedBidiClass")        { Write(DerivedBidiClass{data_path}, include_path); }
-            else if (k == "GeneralCategory") { Write(DerivedGeneralCategory{data_path}, include_path); }
-            else if (k == "Scripts")          { Write(Scripts{data_path}, include_path); }
-            else { throw std::runtime_error{"Misalignment targets:Write"}; }
-        } catch(const std::exception& e) {
-            std::println("failed");
-            std::println("Exception caught:");
-            std::println("{}", e.what());
-            break;
+            results[index] = Update(target, data_path, include_path, manifest.Find(target.name), entries[index],
+                                    force);
+        } catch (const std::exception& e) {
+            results[index] = std::format("failed\nException caught:\n{}", e.what());
+            failed[index] = 1;
         }
-        std::println("done");
+    });
+
+    bool any_failed = false;
+    for (size_t index = 0; index < chosen.size(); ++index) {
+        std::println("Generating {} ... {}", targets[chosen[index]].name, results[index]);
+        if (failed[index]) { any_failed = true; }
+        else { manifest.Set(targets[chosen[index]].name, std::move(entries[index])); }
+    }
+
+    try {
+        manifest.Save(manifest_path);
+    } catch (const std::exception& e) {
+        std::println("Failed to save {}: {}", manifest_path.generic_string(), e.what());
     }
 
-    return 0;
+    return any_failed ? 1 : 0;
 }
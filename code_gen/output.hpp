@@ -0,0 +1,143 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <map>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jcu/ucd/data_file.hpp"
+
+
+namespace jcu::code_gen {
+
+
+/* FNV-1a; only used to notice that a file changed. */
+constexpr uint64_t HashBytes(std::string_view bytes) noexcept {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+
+/* Hash of the file at path, or 0 if there is no such file. */
+uint64_t HashFile(const std::filesystem::path& path) {
+    if (!std::filesystem::exists(path)) { return 0; }
+    return HashBytes(jcu::ucd::MappedFile{path}.View());
+}
+
+
+/***
+ * Replace the file at path with content unless it already holds exactly that; returns true if the file was written.
+ * Leaving an unchanged header alone keeps its timestamp so nothing that includes it is rebuilt.  The content is written
+ * to a temporary file beside path and renamed over it so a reader never sees a partial header.
+ */
+bool WriteIfChanged(const std::filesystem::path& path, std::string_view content) {
+    if (std::filesystem::exists(path) && jcu::ucd::MappedFile{path}.View() == content) { return false; }
+
+    std::filesystem::path temp_path{path};
+    temp_path += ".tmp";
+    {
+        std::ofstream out{temp_path, std::ios::out | std::ios::binary | std::ios::trunc};
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        out.close();
+        if (!out) { throw std::runtime_error{std::format("Failed to write: {}", temp_path.generic_string())}; }
+    }
+    std::filesystem::rename(temp_path, path);
+    return true;
+}
+
+
+/***
+ * What each target was last generated from, kept beside the data files.  A target whose generator version, UCD version
+ * and input hashes match its entry, and whose header still hashes to what was written, is not parsed again.  One line
+ * per target of tab separated fields: name, generator, version, output path, output hash, then input=hash pairs.
+ */
+class Manifest {
+public:
+    struct Entry {
+        std::string generator{};
+        std::string version{};
+        std::filesystem::path output{};
+        uint64_t output_hash{0};
+        std::vector<std::pair<std::string, uint64_t>> inputs{};
+
+        /* Same sources as other; the output is checked separately. */
+        bool SameInputs(const Entry& other) const {
+            return generator == other.generator && version == other.version && inputs == other.inputs;
+        }
+    };
+
+private:
+    std::map<std::string, Entry, std::less<>> entries{};
+
+public:
+    static constexpr const char* FILE_NAME = "code_gen.manifest";
+
+    Manifest() = default;
+
+    /* Entries of the manifest at path; a missing or unreadable manifest is empty so every target is generated. */
+    explicit Manifest(const std::filesystem::path& path) {
+        if (!std::filesystem::exists(path)) { return; }
+        jcu::ucd::LineCursor cursor{jcu::ucd::MappedFile::Open(path)};
+        std::string_view line{};
+        while (cursor.Next(line)) {
+            std::vector<std::string_view> fields{};
+            for (size_t start = 0; start <= line.size();) {
+                size_t end = std::min(line.find('\t', start), line.size());
+                fields.push_back(line.substr(start, end - start));
+                start = end + 1;
+            }
+            if (fields.size() < 5) { continue; }
+
+            try {
+                Entry entry{.generator=std::string{fields[1]}, .version=std::string{fields[2]}, .output=fields[3],
+                            .output_hash=jcu::ucd::ParseInteger<uint64_t>(fields[4], 16)};
+                for (std::string_view input : fields | std::views::drop(5)) {
+                    size_t equal = input.rfind('=');
+                    if (equal == std::string_view::npos) { throw std::runtime_error{"Missing input hash"}; }
+                    entry.inputs.emplace_back(input.substr(0, equal),
+                                              jcu::ucd::ParseInteger<uint64_t>(input.substr(equal + 1), 16));
+                }
+                entries.insert_or_assign(std::string{fields[0]}, std::move(entry));
+            } catch (const std::runtime_error&) {
+                // A damaged entry only costs a regeneration of its target.
+            }
+        }
+    }
+
+    const Entry* Find(std::string_view name) const {
+        auto it = entries.find(name);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    void Set(std::string_view name, Entry entry) { entries.insert_or_assign(std::string{name}, std::move(entry)); }
+
+    /* Write the manifest if it changed; see WriteIfChanged. */
+    void Save(const std::filesystem::path& path) const {
+        std::string content{};
+        for (const auto& [name, entry] : entries) {
+            content += std::format("{}\t{}\t{}\t{}\t{:016x}", name, entry.generator, entry.version,
+                                   entry.output.generic_string(), entry.output_hash);
+            for (const auto& [input, hash] : entry.inputs) { content += std::format("\t{}={:016x}", input, hash); }
+            content += '\n';
+        }
+        WriteIfChanged(path, content);
+    }
+};
+
+
+}
@@ -0,0 +1,243 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+
+/***
+ * Opt-in allocation tracking.
+ *
+ * Allocations are seen by replacing the global allocation functions: expand JCU_INSTALL_ALLOCATION_TRACKING() at
+ * namespace scope in exactly one translation unit of the program.  Each allocation is then counted for the thread that
+ * made it, which is all AllocationScope needs, e.g. for a test asserting that a path does not allocate.
+ *
+ * Defining JCU_TRACK_ALLOCATIONS (for every translation unit, e.g. from the build) also makes the public entry points
+ * of the library (jcu::utf conversions, jcu::bidi runs and jcu::ucd file iterators) record their calls and allocations
+ * per API, read with AllocationReport.  Only the outermost tracked call of a thread records, so ConvertToUTF8 counts
+ * what its encoding does rather than each code point being counted again as EncodeUTF8, and allocations of worker
+ * threads (ToRunsParallel) are not attributed to the call.  Without the macro JCU_ALLOCATION_API expands to nothing.
+ *
+ * A tracked call costs a few thread local reads and relaxed atomic adds, so a production build may enable it and read
+ * the report periodically to spot regressions.
+ */
+namespace jcu {
+
+
+struct AllocationCounts {
+    uint64_t count{0};
+    uint64_t bytes{0};
+
+    constexpr bool operator==(const AllocationCounts&) const = default;
+    constexpr AllocationCounts operator-(const AllocationCounts& rhs) const {
+        return {.count=count - rhs.count, .bytes=bytes - rhs.bytes};
+    }
+};
+
+
+/* Calls of one API and the allocations made by them, as reported by AllocationReport. */
+struct ApiAllocations {
+    std::string_view api{};
+    uint64_t calls{0};
+    AllocationCounts allocations{};
+};
+
+
+namespace detail {
+
+
+inline thread_local AllocationCounts thread_allocations{};
+inline thread_local size_t tracked_api_depth{0};
+
+
+/* Calls and allocations of one API; a counter registers itself once, on the first call of its API. */
+class ApiCounter {
+    std::string_view api;
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+    ApiCounter* next{nullptr};
+
+    static std::mutex& Mutex() { static std::mutex mutex{}; return mutex; }
+    static ApiCounter*& Head() { static ApiCounter* head = nullptr; return head; }
+
+public:
+    explicit ApiCounter(std::string_view api) : api{api} {
+        std::scoped_lock lock{Mutex()};
+        next = Head();
+        Head() = this;
+    }
+
+    ApiCounter(const ApiCounter&) = delete;
+    ApiCounter& operator=(const ApiCounter&) = delete;
+
+    void Record(const AllocationCounts& allocations) noexcept {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(allocations.count, std::memory_order_relaxed);
+        bytes.fetch_add(allocations.bytes, std::memory_order_relaxed);
+    }
+
+    /* Counters of the same API (e.g. one per instantiation of a template) are summed. */
+    static std::vector<ApiAllocations> Report() {
+        std::vector<ApiAllocations> report{};
+        std::scoped_lock lock{Mutex()};
+        for (ApiCounter* counter = Head(); counter; counter = counter->next) {
+            uint64_t calls = counter->calls.load(std::memory_order_relaxed);
+            if (!calls) { continue; }
+            auto it = std::ranges::find(report, counter->api, &ApiAllocations::api);
+            if (it == report.end()) { it = report.insert(it, {.api=counter->api}); }
+            it->calls += calls;
+            it->allocations.count += counter->count.load(std::memory_order_relaxed);
+            it->allocations.bytes += counter->bytes.load(std::memory_order_relaxed);
+        }
+        std::ranges::sort(report, {}, &ApiAllocations::api);
+        return report;
+    }
+
+    static void Reset() {
+        std::scoped_lock lock{Mutex()};
+        for (ApiCounter* counter = Head(); counter; counter = counter->next) {
+            counter->calls.store(0, std::memory_order_relaxed);
+            counter->count.store(0, std::memory_order_relaxed);
+            counter->bytes.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+
+/* Records the allocations of the enclosing call to counter when it is the outermost tracked call of the thread. */
+class ApiScope {
+    ApiCounter* counter;
+    bool outermost{false};
+    AllocationCounts start{};
+
+public:
+    constexpr explicit ApiScope(ApiCounter* counter) : counter{counter} {
+        if (!counter) { return; }
+        outermost = tracked_api_depth++ == 0;
+        if (outermost) { start = thread_allocations; }
+    }
+
+    ApiScope(const ApiScope&) = delete;
+    ApiScope& operator=(const ApiScope&) = delete;
+
+    constexpr ~ApiScope() {
+        if (!counter) { return; }
+        --tracked_api_depth;
+        if (outermost) { counter->Record(thread_allocations - start); }
+    }
+};
+
+
+inline void* TrackedAllocate(std::size_t size, std::size_t alignment) {
+    ++thread_allocations.count;
+    thread_allocations.bytes += size;
+    size = size ? size : 1;
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        ptr = std::malloc(size);
+    } else {
+#if defined(_WIN32)
+        ptr = _aligned_malloc(size, alignment);
+#else
+        ptr = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+    }
+    if (!ptr) { throw std::bad_alloc{}; }
+    return ptr;
+}
+
+
+inline void TrackedFree(void* ptr, std::size_t alignment) noexcept {
+#if defined(_WIN32)
+    if (alignment > alignof(std::max_align_t)) { _aligned_free(ptr); return; }
+#endif
+    (void)alignment;
+    std::free(ptr);
+}
+
+
+}
+
+
+/* Allocations made by the calling thread since it started; always zero unless tracking is installed. */
+inline AllocationCounts ThreadAllocations() noexcept { return detail::thread_allocations; }
+
+
+/***
+ * Allocations made by the calling thread from construction to Counts, e.g.
+ *
+ *     jcu::AllocationScope scope{};
+ *     jcu::bidi::AppendRuns(workspace, text, base_level, runs);
+ *     assert(scope.Counts().count == 0);
+ */
+class AllocationScope {
+    AllocationCounts start{ThreadAllocations()};
+
+public:
+    AllocationCounts Counts() const noexcept { return ThreadAllocations() - start; }
+};
+
+
+/* Calls and allocations per API since the start of the program or the last ResetAllocationReport, by API name. */
+inline std::vector<ApiAllocations> AllocationReport() { return detail::ApiCounter::Report(); }
+
+
+inline void ResetAllocationReport() { detail::ApiCounter::Reset(); }
+
+
+}
+
+
+/***
+ * Track the allocations of the enclosing public function as api.  Usable in constexpr functions; nothing is tracked
+ * during constant evaluation.
+ */
+#if defined(JCU_TRACK_ALLOCATIONS)
+#define JCU_ALLOCATION_API(api)                                                                                      \
+    ::jcu::detail::ApiScope jcu_allocation_api_scope_{std::is_constant_evaluated() ? nullptr : []() {                \
+        static ::jcu::detail::ApiCounter counter{api};                                                               \
+        return &counter;                                                                                             \
+    }()}
+#else
+#define JCU_ALLOCATION_API(api) static_cast<void>(0)
+#endif
+
+
+/* Replacement global allocation functions counting every allocation; expand in exactly one translation unit. */
+#define JCU_INSTALL_ALLOCATION_TRACKING()                                                                            \
+    void* operator new(std::size_t size) { return ::jcu::detail::TrackedAllocate(size, 0); }                         \
+    void* operator new[](std::size_t size) { return ::jcu::detail::TrackedAllocate(size, 0); }                       \
+    void* operator new(std::size_t size, std::align_val_t alignment) {                                              \
+        return ::jcu::detail::TrackedAllocate(size, static_cast<std::size_t>(alignment));                            \
+    }                                                                                                                \
+    void* operator new[](std::size_t size, std::align_val_t alignment) {                                            \
+        return ::jcu::detail::TrackedAllocate(size, static_cast<std::size_t>(alignment));                            \
+    }                                                                                                                \
+    void operator delete(void* ptr) noexcept { ::jcu::detail::TrackedFree(ptr, 0); }                                 \
+    void operator delete[](void* ptr) noexcept { ::jcu::detail::TrackedFree(ptr, 0); }                               \
+    void operator delete(void* ptr, std::size_t) noexcept { ::jcu::detail::TrackedFree(ptr, 0); }                    \
+    void operator delete[](void* ptr, std::size_t) noexcept { ::jcu::detail::TrackedFree(ptr, 0); }                  \
+    void operator delete(void* ptr, std::align_val_t alignment) noexcept {                                          \
+        ::jcu::detail::TrackedFree(ptr, static_cast<std::size_t>(alignment));                                        \
+    }                                                                                                                \
+    void operator delete[](void* ptr, std::align_val_t alignment) noexcept {                                        \
+        ::jcu::detail::TrackedFree(ptr, static_cast<std::size_t>(alignment));                                        \
+    }                                                                                                                \
+    void operator delete(void* ptr, std::size_t, std::align_val_t alignment) noexcept {                             \
+        ::jcu::detail::TrackedFree(ptr, static_cast<std::size_t>(alignment));                                        \
+    }                                                                                                                \
+    void operator delete[](void* ptr, std::size_t, std::align_val_t alignment) noexcept {                           \
+        ::jcu::detail::TrackedFree(ptr, static_cast<std::size_t>(alignment));                                        \
+    }                                                                                                                \
+    static_assert(true)
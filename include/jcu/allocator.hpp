@@ -0,0 +1,52 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+
+/***
+ * Allocators for the results and working memory of the library.
+ *
+ * Functions taking an allocator accept any allocator and rebind it to the element type they produce, so a single
+ * std::pmr::polymorphic_allocator<> (e.g. over a per-request std::pmr::monotonic_buffer_resource) serves all of them:
+ *
+ *     std::pmr::monotonic_buffer_resource arena{};
+ *     std::pmr::polymorphic_allocator<> allocator{&arena};
+ *     std::pmr::u16string text16 = jcu::utf::ConvertToUTF16(text, allocator);
+ *     std::pmr::vector<jcu::bidi::Run> runs = jcu::bidi::ToRuns(text16, allocator);
+ *
+ * Working memory (e.g. jcu::bidi::BidiWorkspace) is std::pmr based.  It is taken from the resource of a
+ * polymorphic_allocator and from the default resource for any other allocator.
+ */
+namespace jcu {
+
+
+template <typename T>
+concept Allocator_c = requires(T allocator, size_t n) {
+    typename T::value_type;
+    { allocator.allocate(n) } -> std::same_as<typename T::value_type*>;
+    allocator.deallocate(allocator.allocate(n), n);
+};
+
+
+template <Allocator_c Allocator_t, typename T>
+using RebindAllocator_t = typename std::allocator_traits<Allocator_t>::template rebind_alloc<T>;
+
+
+/* Resource for the working memory of a call given the allocator of its result. */
+template <Allocator_c Allocator_t>
+std::pmr::memory_resource* MemoryResourceOf(const Allocator_t& allocator) noexcept {
+    if constexpr (requires { { allocator.resource() } -> std::convertible_to<std::pmr::memory_resource*>; }) {
+        return allocator.resource();
+    } else {
+        return std::pmr::get_default_resource();
+    }
+}
+
+
+}
@@ -4,71 +4,515 @@
 
 
 #include <algorithm>
+#include <cassert>
 #include <concepts>
 #include <cstdint>
+#include <format>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <span>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "jcu/allocation.hpp"
+#include "jcu/allocator.hpp"
 #include "jcu/bidi/bidi_type.hpp"
 #include "jcu/bidi/level.hpp"
 #include "jcu/bidi/bidi_chain.hpp"
 #include "jcu/bidi/status_stack.hpp"
+#include "jcu/bidi/isolate_pairs.hpp"
 #include "jcu/bidi/run_queue.hpp"
 #include "jcu/bidi/isolating_run.hpp"
 #include "jcu/bidi/runs.hpp"
+#include "jcu/bidi/trace.hpp"
+#include "jcu/classify.hpp"
+#include "jcu/constants.hpp"
+#include "jcu/data/bidi_brackets.hpp"
 #include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/parallel.hpp"
 #include "jcu/utf/utf.hpp"
 
 
 namespace jcu::bidi {
 
 
-BidiLevel DetermineBaseLevel(const BidiChain&, BidiLink, BidiLink, BidiLevel, bool);
-template <typename Range_t> requires jcu::utf::IsUTF32CompatibleReduced_c<std::ranges::range_value_t<Range_t>>
-void DetermineLevels(Range_t&&, BidiChain&, BidiLevel);
-BidiLink SkipIsolatingRun(const BidiChain&, BidiLink, BidiLink);
+template <typename Chain_t>
+BidiLevel DetermineBaseLevel(IsolatePairs<Chain_t>&, typename Chain_t::link_type, BidiLevel);
+template <typename Chain_t, typename Trace_t=NoTrace> struct ChainWorkspace;
+template <BidiChainLayout Layout, typename Trace_t> struct BidiWorkspace;
+template <typename Chain_t, typename Trace_t>
+void DetermineLevels(std::span<const jcu::data::BidiBracketTag>, ChainWorkspace<Chain_t, Trace_t>&, BidiLevel);
+template <typename Chain_t, typename Trace_t>
+void ResolveSequencesParallel(std::span<const jcu::data::BidiBracketTag>,
+                              ChainWorkspace<Chain_t, Trace_t>&, BidiLevel);
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+BidiLevel ResolveLevels(const std::vector<char32_t>&, std::span<const BidiType>, BidiLevel, std::span<BidiLevel>);
+template <BidiChainLayout Layout, typename Trace_t>
+BidiLevel ResolveLevels(BidiWorkspace<Layout, Trace_t>&,
+                        const std::vector<char32_t>&, std::span<const BidiType>, BidiLevel, std::span<BidiLevel>);
+template <typename Chain_t>
+BidiLevel ResolveChainLevels(std::span<const jcu::data::BidiBracketTag>,
+                             std::span<const BidiType>, BidiLevel, std::span<BidiLevel>);
+template <typename Chain_t, typename Trace_t>
+BidiLevel ResolveChainLevels(ChainWorkspace<Chain_t, Trace_t>&,
+                             std::span<const jcu::data::BidiBracketTag>,
+                             std::span<const BidiType>, BidiLevel, std::span<BidiLevel>);
+template <BidiChainLayout Layout, typename Trace_t, typename Allocator_t>
+BidiLevel ResolveRuns(BidiWorkspace<Layout, Trace_t>&,
+                      std::span<const jcu::data::BidiBracketTag>,
+                      std::span<const BidiType>, BidiLevel, std::vector<Run, Allocator_t>&);
+template <BidiChainLayout Layout, typename Trace_t, typename Func_t>
+decltype(auto) VisitChainWorkspace(BidiWorkspace<Layout, Trace_t>&, size_t, Func_t&&);
+template <typename Chain_t, typename Trace_t>
+BidiLevel ResolveChain(ChainWorkspace<Chain_t, Trace_t>&,
+                       std::span<const jcu::data::BidiBracketTag>, std::span<const BidiType>, BidiLevel);
+template <typename Chain_t, typename Allocator_t>
+void AppendChainRuns(const Chain_t&, BidiLevel, std::span<const Run>, std::vector<Run, Allocator_t>&);
+template <typename Chain_t>
+typename Chain_t::link_type SkipIsolatingRun(IsolatePairs<Chain_t>&, typename Chain_t::link_type);
+
+
+/***
+ * Memory used to resolve a paragraph with a Chain_t, kept together so that it can be reused from one paragraph to the
+ * next; it only grows to fit the largest paragraph seen.  Trace_t is the tracing policy (see BidiWorkspace).
+ */
+template <typename Chain_t, typename Trace_t>
+struct ChainWorkspace {
+    Chain_t bidi_chain{};
+    IsolatePairs<Chain_t> isolate_pairs{};
+    RunQueue<typename Chain_t::link_type> run_queue{};
+    IsolatingRun<Chain_t> isolating_run{};
+    [[no_unique_address]] Trace_t trace{};
+
+    // Isolating run sequences are resolved on this many threads when above one (see ResolveSequencesParallel).
+    size_t threads{1};
+    std::pmr::vector<LevelRun<typename Chain_t::link_type>> sequence_runs{};  //< Level runs of each sequence, in order.
+    std::pmr::vector<size_t> sequence_starts{};                               //< First level run of each sequence.
+    std::pmr::vector<IsolatingRun<Chain_t>> isolating_runs{};                 //< One per thread.
+    std::pmr::vector<Trace_t> thread_traces{};                                //< One per thread when tracing.
+
+    ChainWorkspace() = default;
+    explicit ChainWorkspace(std::pmr::memory_resource* resource)
+        : bidi_chain{resource}, isolate_pairs{resource}, run_queue{resource},
+          sequence_runs{resource}, sequence_starts{resource}, isolating_runs{resource}, thread_traces{resource} {}
+};
+
+
+/***
+ * Reusable memory for resolving paragraphs: the per code unit arrays and a chain workspace for each link width.  All
+ * of it comes from the memory resource given at construction (the default resource otherwise), e.g. a per-request
+ * std::pmr::monotonic_buffer_resource that is released with the workspace.
+ *
+ * Trace_t is the tracing policy: NoTrace records nothing and compiles away; BidiTrace records the time and work of
+ * each phase of every paragraph resolved with the workspace until ResetTrace, read with Trace.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, typename Trace_t=NoTrace>
+struct BidiWorkspace {
+    std::pmr::vector<BidiType> bidi_types{};
+    std::pmr::vector<jcu::data::BidiBracketTag> bracket_tags{};
+    std::pmr::vector<Run> resets{};  //< Code units reset by rule L1 (see FindResetRuns).
+    std::pmr::vector<Run> runs{};    //< For callers that only need the runs of a paragraph while producing others.
+    size_t threads{1};               //< Threads resolving the isolating run sequences of a paragraph (ToRunsParallel).
+    [[no_unique_address]] Trace_t trace{};  //< Phases outside of the chain workspaces.
+    ChainWorkspace<BidiChain<uint16_t, Layout>, Trace_t> narrow{};
+    ChainWorkspace<BidiChain<uint32_t, Layout>, Trace_t> wide{};
+
+    BidiWorkspace() = default;
+    explicit BidiWorkspace(std::pmr::memory_resource* resource)
+        : bidi_types{resource}, bracket_tags{resource}, resets{resource}, runs{resource},
+          narrow{resource}, wide{resource} {}
+
+    /* Counts of all paragraphs resolved since construction or ResetTrace. */
+    Trace_t Trace() const {
+        Trace_t result = trace;
+        result.Add(narrow.trace);
+        result.Add(wide.trace);
+        return result;
+    }
+
+    void ResetTrace() {
+        trace.Reset();
+        narrow.trace.Reset();
+        wide.trace.Reset();
+    }
+};
+
+
+/***
+ * Runs of many paragraphs in one contiguous buffer.  The runs of paragraph i, in visual order, are
+ * runs[offsets[i], offsets[i] + counts[i]); their offsets are relative to the start of that paragraph.  The buffers
+ * are allocated by Allocator_t rebound to their element types; see RunsBatch and pmr::RunsBatch.
+ */
+template <jcu::Allocator_c Allocator_t=std::allocator<Run>>
+struct BasicRunsBatch {
+    std::vector<Run, jcu::RebindAllocator_t<Allocator_t, Run>> runs{};
+    std::vector<size_t, jcu::RebindAllocator_t<Allocator_t, size_t>> offsets{};
+    std::vector<size_t, jcu::RebindAllocator_t<Allocator_t, size_t>> counts{};
+
+    BasicRunsBatch() = default;
+    explicit BasicRunsBatch(const Allocator_t& allocator) : runs(allocator), offsets(allocator), counts(allocator) {}
+};
+
+
+using RunsBatch = BasicRunsBatch<>;
 
 
+namespace pmr { using RunsBatch = BasicRunsBatch<std::pmr::polymorphic_allocator<Run>>; }
+
+
+/***
+ * Bidi class of a code point; invalid code points (e.g. from ill-formed input) are treated like U+FFFD which is ON.
+ */
+constexpr BidiType ClassifyCodePoint(char32_t code_point) noexcept {
+    return jcu::utf::IsCodePointValid(code_point) ? jcu::data::DerivedBidiClass::Lookup(code_point) : BidiType::ON;
+}
+
+
+/* Bracket tag of a code point of the given bidi class; paired brackets are all ON so the search is skipped otherwise. */
+constexpr jcu::data::BidiBracketTag ClassifyBracket(char32_t code_point, BidiType bidi_type) noexcept {
+    if (bidi_type != BidiType::ON) { return 0; }
+    return jcu::data::MakeBidiBracketTag(jcu::data::BidiBrackets::Lookup(code_point));
+}
+
+
+/***
+ * Resolve the runs of a paragraph in visual order.  Run offsets and lengths are in code units of the input: forward
+ * ranges are classified per code unit in the same pass that decodes them (see jcu::Classify); input ranges are
+ * processed per code point.
+ *
+ * Layout selects the memory layout of the internal BidiChain.  The width of its links is chosen from the length of
+ * the input: 16-bit links when it fits, 32-bit links otherwise.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE>
 std::vector<Run> ToRuns(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
                         BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO,
                         bool reserve=false) {
-    if (code_points_rng.begin() == code_points_rng.end()) { return {}; }
+    JCU_ALLOCATION_API("jcu::bidi::ToRuns");
+    BidiWorkspace<Layout> workspace{};
+    std::vector<Run> runs{};
+    AppendRuns(workspace, std::forward<decltype(code_points_rng)>(code_points_rng), base_level, runs, reserve);
+    return runs;
+}
+
+
+/***
+ * Same as above with the runs allocated by allocator rebound to Run.  The working memory of the call comes from the
+ * resource of allocator when it is a polymorphic_allocator (see jcu/allocator.hpp), so a single arena holds all of it.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, jcu::Allocator_c Allocator_t>
+std::vector<Run, jcu::RebindAllocator_t<Allocator_t, Run>> ToRuns(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+                                                                  const Allocator_t& allocator,
+                                                                  BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO,
+                                                                  bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRuns");
+    BidiWorkspace<Layout> workspace{jcu::MemoryResourceOf(allocator)};
+    std::vector<Run, jcu::RebindAllocator_t<Allocator_t, Run>> runs(allocator);
+    AppendRuns(workspace, std::forward<decltype(code_points_rng)>(code_points_rng), base_level, runs, reserve);
+    return runs;
+}
+
+
+/* Runs of a paragraph with the trace of resolving it, as returned by ToRunsTraced. */
+struct TracedRuns {
+    std::vector<Run> runs{};
+    BidiTrace trace{};
+};
+
+
+/***
+ * Same as ToRuns also returning the time and work of each phase (see BidiTrace), e.g. to find which rules make a
+ * pathological input slow to lay out.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+TracedRuns ToRunsTraced(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+                        BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsTraced");
+    BidiWorkspace<Layout, BidiTrace> workspace{};
+    TracedRuns result{};
+    AppendRuns(workspace, std::forward<decltype(code_points_rng)>(code_points_rng), base_level, result.runs);
+    result.trace = workspace.Trace();
+    return result;
+}
+
+
+/***
+ * Same as ToRuns with the isolating run sequences of the paragraph resolved concurrently on up to threads threads (0
+ * for one per hardware thread).  Opt in for very long paragraphs with many sequences, e.g. minified data mixing
+ * directions; the runs are the same as those of ToRuns.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+std::vector<Run> ToRunsParallel(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+                                size_t threads=0,
+                                BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsParallel");
+    BidiWorkspace<Layout> workspace{};
+    workspace.threads = threads ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<Run> runs{};
+    AppendRuns(workspace, std::forward<decltype(code_points_rng)>(code_points_rng), base_level, runs);
+    return runs;
+}
+
+
+/* Same as above with the runs and working memory allocated as for ToRuns with an allocator. */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, jcu::Allocator_c Allocator_t>
+std::vector<Run, jcu::RebindAllocator_t<Allocator_t, Run>> ToRunsParallel(
+        jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+        const Allocator_t& allocator,
+        size_t threads=0,
+        BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsParallel");
+    BidiWorkspace<Layout> workspace{jcu::MemoryResourceOf(allocator)};
+    workspace.threads = threads ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+    std::vector<Run, jcu::RebindAllocator_t<Allocator_t, Run>> runs(allocator);
+    AppendRuns(workspace, std::forward<decltype(code_points_rng)>(code_points_rng), base_level, runs);
+    return runs;
+}
 
-    jcu::utf::CodePointView code_points_view{std::forward<decltype(code_points_rng)>(code_points_rng)};
 
-    std::vector<BidiType> bidi_types{};
-    if constexpr (std::ranges::sized_range<decltype(code_points_view)>) {
-        bidi_types.reserve(code_points_view.size());
-    } else {
-        if (reserve) { bidi_types.reserve(std::ranges::distance(code_points_view)); }
+/***
+ * Resolve one paragraph using the memory of workspace, append its runs, in visual order, to runs and return the
+ * paragraph embedding level.  Offsets are in code units of the input as for ToRuns.
+ */
+template <BidiChainLayout Layout, typename Trace_t, typename Allocator_t>
+BidiLevel AppendRuns(BidiWorkspace<Layout, Trace_t>& workspace,
+                jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+                BidiLevel base_level,
+                std::vector<Run, Allocator_t>& runs,
+                bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::bidi::AppendRuns");
+    using Range_t = decltype(code_points_rng);
+
+    std::pmr::vector<BidiType>& bidi_types = workspace.bidi_types;
+    std::pmr::vector<jcu::data::BidiBracketTag>& bracket_tags = workspace.bracket_tags;
+    bidi_types.clear();
+    bracket_tags.clear();
+
+    {
+        typename Trace_t::Scope scope{workspace.trace, BidiPhase::CLASSIFY};
+        if constexpr (std::ranges::forward_range<Range_t>) {
+            size_t length = 0;
+            if constexpr (std::ranges::sized_range<Range_t>) { length = std::ranges::size(code_points_rng); }
+            else { length = static_cast<size_t>(std::ranges::distance(code_points_rng)); }
+
+            bidi_types.resize(length);
+            bracket_tags.resize(length);
+            jcu::Classify<jcu::ClassifyIndex::CODE_UNIT>(std::forward<Range_t>(code_points_rng),
+                                                         {.bidi_types=bidi_types,
+                                                          .bracket_tags=bracket_tags});
+        } else {
+            jcu::utf::CodePointView code_points_view{std::forward<Range_t>(code_points_rng)};
+
+            if constexpr (std::ranges::sized_range<decltype(code_points_view)>) {
+                bidi_types.reserve(code_points_view.size());
+                bracket_tags.reserve(code_points_view.size());
+            } else if (reserve) {
+                bidi_types.reserve(std::ranges::distance(code_points_view));
+                bracket_tags.reserve(bidi_types.capacity());
+            }
+            for (char32_t code_point : code_points_view) {
+                BidiType type = ClassifyCodePoint(code_point);
+                bidi_types.push_back(type);
+                bracket_tags.push_back(ClassifyBracket(code_point, type));
+            }
+        }
+        workspace.trace.Work(BidiPhase::CLASSIFY, bidi_types.size());
+    }
+    if (bidi_types.empty()) {
+        if (base_level < LEVEL_TYPE_MAX) { return base_level; }
+        return base_level == LEVEL_TYPE_DEFAULT_RTL ? LEVEL_TYPE_RTL : LEVEL_TYPE_LTR;
     }
-    std::ranges::transform(code_points_view, std::back_inserter(bidi_types), jcu::data::DerivedBidiClass::Lookup);
 
-    BidiChain bidi_chain{bidi_types};
+    size_t first = runs.size();
+    BidiLevel resolved_level = ResolveRuns(workspace, bracket_tags, bidi_types, base_level, runs);
+    typename Trace_t::Scope scope{workspace.trace, BidiPhase::REORDER};
+    workspace.trace.Work(BidiPhase::REORDER, runs.size() - first);
+    ReorderRuns(std::span{runs}.subspan(first));
+    return resolved_level;
+}
 
-    BidiLevel resolved_level = base_level;
-    if (base_level >= LEVEL_TYPE_MAX) {
-        resolved_level = DetermineBaseLevel(bidi_chain,
-                                            bidi_chain.Roller(),
-                                            bidi_chain.Roller(),
-                                            (base_level == LEVEL_TYPE_DEFAULT_RTL ? 1 : 0),
-                                            false);
+
+/***
+ * Runs of many short paragraphs (e.g. the labels of a UI) resolved with one shared workspace, so the chain, queues and
+ * arrays are set up once for the batch rather than once per string.  Each string is a separate paragraph.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, std::ranges::input_range Strings_t>
+requires jcu::utf::IsCompatibleRange_c<std::ranges::range_reference_t<Strings_t>>
+RunsBatch ToRunsBatch(Strings_t&& strings, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsBatch");
+    BidiWorkspace<Layout> workspace{};
+    RunsBatch batch{};
+    ToRunsBatch(std::forward<Strings_t>(strings), workspace, batch, base_level);
+    return batch;
+}
+
+
+/* Same as above with the batch and working memory allocated as for ToRuns with an allocator. */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, std::ranges::input_range Strings_t,
+          jcu::Allocator_c Allocator_t>
+requires jcu::utf::IsCompatibleRange_c<std::ranges::range_reference_t<Strings_t>>
+BasicRunsBatch<jcu::RebindAllocator_t<Allocator_t, Run>> ToRunsBatch(Strings_t&& strings,
+                                                                     const Allocator_t& allocator,
+                                                                     BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsBatch");
+    BidiWorkspace<Layout> workspace{jcu::MemoryResourceOf(allocator)};
+    BasicRunsBatch<jcu::RebindAllocator_t<Allocator_t, Run>> batch{allocator};
+    ToRunsBatch(std::forward<Strings_t>(strings), workspace, batch, base_level);
+    return batch;
+}
+
+
+/* Same as above, reusing the memory of workspace and batch from a prior call (e.g. the previous frame). */
+template <BidiChainLayout Layout, typename Trace_t, std::ranges::input_range Strings_t, typename Allocator_t>
+requires jcu::utf::IsCompatibleRange_c<std::ranges::range_reference_t<Strings_t>>
+void ToRunsBatch(Strings_t&& strings,
+                 BidiWorkspace<Layout, Trace_t>& workspace,
+                 BasicRunsBatch<Allocator_t>& batch,
+                 BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRunsBatch");
+    batch.runs.clear();
+    batch.offsets.clear();
+    batch.counts.clear();
+    if constexpr (std::ranges::sized_range<Strings_t>) {
+        batch.offsets.reserve(std::ranges::size(strings));
+        batch.counts.reserve(std::ranges::size(strings));
+    }
+
+    for (auto&& string : strings) {
+        size_t first = batch.runs.size();
+        AppendRuns(workspace, string, base_level, batch.runs);
+        batch.offsets.push_back(first);
+        batch.counts.push_back(batch.runs.size() - first);
+    }
+}
+
+
+/***
+ * Same as ToRuns but also fills caller provided logical-to-visual and visual-to-logical index maps (see
+ * CreateIndexMaps).  Either map may be empty to skip it.
+ */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+std::vector<Run> ToRuns(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
+                        std::span<uint32_t> logical_to_visual,
+                        std::span<uint32_t> visual_to_logical,
+                        BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO,
+                        bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::bidi::ToRuns");
+    std::vector<Run> runs = ToRuns<Layout>(std::forward<decltype(code_points_rng)>(code_points_rng), base_level, reserve);
+    CreateIndexMaps(runs, logical_to_visual, visual_to_logical);
+    return runs;
+}
+
+
+/***
+ * Resolve the embedding level of every code point (before rule L1) into levels and return the paragraph embedding
+ * level.  The width of the BidiChain links is chosen from the length of the input: 16-bit links when it fits, 32-bit
+ * links otherwise.
+ */
+template <BidiChainLayout Layout>
+BidiLevel ResolveLevels(const std::vector<char32_t>& code_points,
+                        std::span<const BidiType> bidi_types,
+                        BidiLevel base_level,
+                        std::span<BidiLevel> levels) {
+    JCU_ALLOCATION_API("jcu::bidi::ResolveLevels");
+    BidiWorkspace<Layout> workspace{};
+    return ResolveLevels(workspace, code_points, bidi_types, base_level, levels);
+}
+
+
+template <BidiChainLayout Layout, typename Trace_t>
+BidiLevel ResolveLevels(BidiWorkspace<Layout, Trace_t>& workspace,
+                        const std::vector<char32_t>& code_points,
+                        std::span<const BidiType> bidi_types,
+                        BidiLevel base_level,
+                        std::span<BidiLevel> levels) {
+    JCU_ALLOCATION_API("jcu::bidi::ResolveLevels");
+    std::pmr::vector<jcu::data::BidiBracketTag>& bracket_tags = workspace.bracket_tags;
+    bracket_tags.resize(bidi_types.size());
+    std::ranges::transform(code_points, bidi_types, bracket_tags.begin(), ClassifyBracket);
+
+    return VisitChainWorkspace(workspace, bidi_types.size(), [&](auto& chain_workspace) {
+        return ResolveChainLevels(chain_workspace, bracket_tags, bidi_types, base_level, levels);
+    });
+}
+
+
+/***
+ * Resolve a paragraph and append its runs, in logical order and with rule L1 applied, to runs; returns the paragraph
+ * embedding level.  The runs come straight from the links of the chain, which are already run-length, and rule L1 is
+ * applied to them a range at a time, so no level per code unit is ever stored.
+ */
+template <BidiChainLayout Layout, typename Trace_t, typename Allocator_t>
+BidiLevel ResolveRuns(BidiWorkspace<Layout, Trace_t>& workspace,
+                      std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                      std::span<const BidiType> bidi_types,
+                      BidiLevel base_level,
+                      std::vector<Run, Allocator_t>& runs) {
+    return VisitChainWorkspace(workspace, bidi_types.size(), [&](auto& chain_workspace) {
+        BidiLevel resolved_level = ResolveChain(chain_workspace, bracket_tags, bidi_types, base_level);
+        typename Trace_t::Scope scope{workspace.trace, BidiPhase::LINE};
+        size_t first = runs.size();
+        FindResetRuns(bidi_types, resolved_level, workspace.resets);
+        AppendChainRuns(chain_workspace.bidi_chain, resolved_level, workspace.resets, runs);
+        workspace.trace.Work(BidiPhase::LINE, runs.size() - first);
+        return resolved_level;
+    });
+}
+
+
+/***
+ * Call func with the chain workspace of workspace whose links are wide enough for length code units: 16-bit links when
+ * they fit, 32-bit links otherwise.
+ */
+template <BidiChainLayout Layout, typename Trace_t, typename Func_t>
+decltype(auto) VisitChainWorkspace(BidiWorkspace<Layout, Trace_t>& workspace, size_t length, Func_t&& func) {
+    using NarrowChain = BidiChain<uint16_t, Layout>;
+    using WideChain = BidiChain<uint32_t, Layout>;
+    // Each thread beyond the first needs a sentinel link of its own.
+    size_t sentinels = workspace.threads > 1 ? workspace.threads : 0;
+    if (length + sentinels <= NarrowChain::MAX_LENGTH) {
+        workspace.narrow.threads = workspace.threads;
+        return std::invoke(func, workspace.narrow);
+    }
+    if (length + sentinels > WideChain::MAX_LENGTH) {
+        throw std::length_error(std::format("Bidi text of length {} exceeds the maximum of {}",
+                                            length, WideChain::MAX_LENGTH - sentinels));
     }
+    workspace.wide.threads = workspace.threads;
+    return std::invoke(func, workspace.wide);
+}
 
-    // tmp until we get it working and factor out isolating_run dep on code_points.  maybe a map?
-    std::vector<char32_t> code_points{};
-    std::ranges::transform(code_points_view, std::back_inserter(code_points), std::identity{});
-    DetermineLevels(code_points, bidi_chain, resolved_level);
+
+template <typename Chain_t>
+BidiLevel ResolveChainLevels(std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                             std::span<const BidiType> bidi_types,
+                             BidiLevel base_level,
+                             std::span<BidiLevel> levels) {
+    ChainWorkspace<Chain_t> workspace{};
+    return ResolveChainLevels(workspace, bracket_tags, bidi_types, base_level, levels);
+}
+
+
+template <typename Chain_t, typename Trace_t>
+BidiLevel ResolveChainLevels(ChainWorkspace<Chain_t, Trace_t>& workspace,
+                             std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                             std::span<const BidiType> bidi_types,
+                             BidiLevel base_level,
+                             std::span<BidiLevel> levels) {
+    using link_type = typename Chain_t::link_type;
+
+    assert(levels.size() >= bidi_types.size());
+
+    const Chain_t& bidi_chain = workspace.bidi_chain;
+    BidiLevel resolved_level = ResolveChain(workspace, bracket_tags, bidi_types, base_level);
 
     // Save levels
-    std::vector<BidiLevel> levels(bidi_types.size(), LEVEL_TYPE_INVALID);
     BidiLevel level = resolved_level;
     size_t index = 0; // SaveLevels(&context->bidiChain, ++paragraph->fixedLevels, resolvedLevel);
-    const BidiLink roller = bidi_chain.Roller();
-    for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+    const link_type roller = bidi_chain.Roller();
+    for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
         size_t offset = BidiChainGetOffset(link);
         for (; index < offset; index++) {
             levels[index] = level;
@@ -76,63 +520,121 @@ std::vector<Run> ToRuns(jcu::utf::IsCompatibleRange_c auto&& code_points_rng,
         level = bidi_chain.GetLevel(link);
     }
 
-    return CreateRuns(bidi_types, levels, resolved_level); // or should it be base_level ... double check
+    return resolved_level;
 }
 
 
-BidiLevel DetermineBaseLevel(const BidiChain& bidi_chain,
-                             BidiLink skip_link,
-                             BidiLink break_link,
-                             BidiLevel default_level,
-                             bool is_isolate)
-{
-    BidiLink link = bidi_chain.GetNext(skip_link);
-    bool is_done = false;
-
-    /* Rules P2, P3 */
-    for (; link != break_link; link = bidi_chain.GetNext(link)) {
-        BidiType type = bidi_chain.GetType(link);
+/* Build the chain of a paragraph and resolve its levels (rules P2 to I2); returns the paragraph embedding level. */
+template <typename Chain_t, typename Trace_t>
+BidiLevel ResolveChain(ChainWorkspace<Chain_t, Trace_t>& workspace,
+                       std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                       std::span<const BidiType> bidi_types,
+                       BidiLevel base_level) {
+    Chain_t& bidi_chain = workspace.bidi_chain;
+    IsolatePairs<Chain_t>& isolate_pairs = workspace.isolate_pairs;
+    BidiLevel resolved_level = base_level;
+    {
+        typename Trace_t::Scope scope{workspace.trace, BidiPhase::PARAGRAPH};
+        workspace.trace.Work(BidiPhase::PARAGRAPH, bidi_types.size());
+        bidi_chain.Assign(bidi_types, workspace.threads > 1 ? workspace.threads : 0);
+        isolate_pairs.Assign(bidi_chain);
+
+        if (base_level >= LEVEL_TYPE_MAX) {
+            resolved_level = DetermineBaseLevel(isolate_pairs,
+                                                bidi_chain.Roller(),
+                                                (base_level == LEVEL_TYPE_DEFAULT_RTL ? 1 : 0));
+        }
+    }
 
-        switch (type) {
-        case BidiType::L:
-            return 0;
+    DetermineLevels(bracket_tags, workspace, resolved_level);
+    return resolved_level;
+}
 
-        case BidiType::AL:
-        case BidiType::R:
-            return 1;
 
-        case BidiType::LRI:
-        case BidiType::RLI:
-        case BidiType::FSI:
-            link = SkipIsolatingRun(bidi_chain, link, break_link);
-            if (link == BIDI_LINK_NONE) { is_done = true; }
-            break;
+/***
+ * Append the runs of a resolved chain in logical order to runs.  Each link covers the code units up to the next one at
+ * a single level; code units before the first link are at the paragraph level.  resets are the ranges reset to the
+ * paragraph level by rule L1 (see FindResetRuns).  Adjacent runs at the same level are merged.
+ */
+template <typename Chain_t, typename Allocator_t>
+void AppendChainRuns(const Chain_t& bidi_chain,
+                     BidiLevel paragraph_level,
+                     std::span<const Run> resets,
+                     std::vector<Run, Allocator_t>& runs) {
+    using link_type = typename Chain_t::link_type;
+
+    size_t first = runs.size();
+    auto Push = [&runs, first](size_t offset, size_t length, BidiLevel level) {
+        if (runs.size() > first && runs.back().level == level) { runs.back().length += length; }
+        else { runs.push_back({.offset=offset, .length=length, .level=level}); }
+    };
 
-        case BidiType::PDI:
-            // In case of isolating run, the PDI will be the last code point.
-            // *NOTE: The inner isolating runs will be skipped by the case above this one.
-            if (is_isolate) { is_done = true; }
-            break;
+    auto reset = resets.begin();
+    auto Append = [&](size_t start, size_t end, BidiLevel level) {
+        while (start < end) {
+            while (reset != resets.end() && reset->offset + reset->length <= start) { ++reset; }
+            if (reset == resets.end() || reset->offset >= end) {
+                Push(start, end - start, level);
+                return;
+            }
+            if (reset->offset > start) {
+                Push(start, reset->offset - start, level);
+                start = reset->offset;
+            }
+            size_t stop = std::min(end, reset->offset + reset->length);
+            Push(start, stop - start, paragraph_level);
+            start = stop;
         }
+    };
 
-        if (is_done) { break; }
+    size_t start = 0;
+    BidiLevel level = paragraph_level;
+    const link_type roller = bidi_chain.Roller();
+    for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+        size_t offset = BidiChainGetOffset(link);
+        Append(start, offset, level);
+        start = offset;
+        level = bidi_chain.GetLevel(link);
     }
+}
+
+
+/***
+ * Rules P2, P3 for the paragraph (skip_link is the roller) or for the isolate initiated at skip_link.  The first strong
+ * types were gathered up front by IsolatePairs so this is a lookup rather than a scan.
+ */
+template <typename Chain_t>
+BidiLevel DetermineBaseLevel(IsolatePairs<Chain_t>& isolate_pairs,
+                             typename Chain_t::link_type skip_link,
+                             BidiLevel default_level)
+{
+    if (skip_link == 0) { return isolate_pairs.GetParagraphLevel(default_level); } // roller
 
-    return default_level;
+    BidiLevel level = isolate_pairs.Find(skip_link).first_strong_level;
+    return level == LEVEL_TYPE_INVALID ? default_level : level;
 }
 
 
-template <typename T>
-requires jcu::utf::IsUTF32CompatibleReduced_c<std::ranges::range_value_t<T>>
-void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_level) {
-    const BidiLink roller = bidi_chain.Roller();
+template <typename Chain_t, typename Trace_t>
+void DetermineLevels(std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                     ChainWorkspace<Chain_t, Trace_t>& workspace,
+                     BidiLevel base_level) {
+    using link_type = typename Chain_t::link_type;
+
+    Chain_t& bidi_chain = workspace.bidi_chain;
+    IsolatePairs<Chain_t>& isolate_pairs = workspace.isolate_pairs;
+    RunQueue<link_type>& run_queue = workspace.run_queue;
+    IsolatingRun<Chain_t>& isolating_run = workspace.isolating_run;
+    Trace_t& trace = workspace.trace;
+    typename Trace_t::Scope scope{trace, BidiPhase::EXPLICIT};
+    run_queue.Clear();
+
+    const link_type roller = bidi_chain.Roller();
     StatusStack status_stack{};
-    RunQueue run_queue{};
-    IsolatingRun isolating_run{};
 
-    BidiLink prior_link = roller;
-    BidiLink first_link = BIDI_LINK_NONE;
-    BidiLink last_link = BIDI_LINK_NONE;
+    link_type prior_link = roller;
+    link_type first_link = Chain_t::LINK_NONE;
+    link_type last_link = Chain_t::LINK_NONE;
     BidiLevel prior_level = base_level;
     BidiType start_of_run = BidiType::NIL;
     BidiType end_of_run = BidiType::NIL;
@@ -160,14 +662,15 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
 
         if (prior_status != BidiType::ON) {
             bidi_chain.SetType(link, prior_status);
-            if (bidi_chain.MergeIfEqual(prior_link, link)) { return true; }
+            if (bidi_chain.MergeIfEqual(prior_link, link)) { trace.Merges(); return true; }
         }
 
         return false;
     };
 
     status_stack.Push(base_level, BidiType::ON, false);
-    for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+    for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+        trace.Work(BidiPhase::EXPLICIT);
         bool force_finish = false;
         bool bn_equivalent = false;
         BidiType type = bidi_chain.GetType(link);
@@ -210,7 +713,7 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
         /* Rule X5c */
         case BidiType::FSI:
         {
-            bool isRTL = DetermineBaseLevel(bidi_chain, link, roller, 0, true) == 1;
+            bool isRTL = DetermineBaseLevel(isolate_pairs, link, 0) == 1;
             BidiLevel which_level = isRTL ? status_stack.LeastGreaterOddLevel() : status_stack.LeastGreaterEvenLevel();
             if (PushIsolate(which_level, BidiType::ON, link)) { continue; }
             break;
@@ -221,7 +724,7 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
             bidi_chain.SetLevel(link, status_stack.GetEmbeddingLevel());
             if (status_stack.GetOverrideStatus() != BidiType::ON) {
                 bidi_chain.SetType(link, status_stack.GetOverrideStatus());
-                if (bidi_chain.MergeIfEqual(prior_link, link)) { continue; }
+                if (bidi_chain.MergeIfEqual(prior_link, link)) { trace.Merges(); continue; }
             }
             break;
 
@@ -242,7 +745,7 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
             BidiType overrideStatus = status_stack.GetOverrideStatus();
             if (overrideStatus != BidiType::ON) {
                 bidi_chain.SetType(link, overrideStatus);
-                if (bidi_chain.MergeIfEqual(prior_link, link)) { continue; }
+                if (bidi_chain.MergeIfEqual(prior_link, link)) { trace.Merges(); continue; }
             }
             break;
         }
@@ -289,6 +792,7 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
             /* The type of this link is BN equivalent, so abandon it and continue the loop. */
             bidi_chain.SetType(link, BidiType::BN);
             bidi_chain.AbandonNext(prior_link);
+            trace.Merges();
             continue;
         }
 
@@ -311,13 +815,18 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
              */
             end_of_run = LevelAsNormalBidiType(std::ranges::max(prior_level, current_level));
 
-            run_queue.Enqueue(LevelRun{bidi_chain, first_link, last_link, start_of_run, end_of_run});
+            run_queue.Enqueue(LevelRun<link_type>{bidi_chain, first_link, last_link, start_of_run, end_of_run});
+            trace.RunQueueSize(run_queue.Size());
             if (run_queue.should_dequeue || force_finish) {
         /* Rule X10 */
-                for (; !run_queue.Empty(); run_queue.Dequeue()) {
-                    LevelRun& peek = run_queue.Peek();
-                    if (IsRunKindAttached(peek.kind)) { continue; }
-                    isolating_run.Resolve(std::forward<T>(code_points), bidi_chain, peek, base_level);
+                if (workspace.threads > 1) {
+                    ResolveSequencesParallel(bracket_tags, workspace, base_level);
+                } else {
+                    for (; !run_queue.Empty(); run_queue.Dequeue()) {
+                        LevelRun<link_type>& peek = run_queue.Peek();
+                        if (IsRunKindAttached(peek.kind)) { continue; }
+                        isolating_run.Resolve(trace, bracket_tags, bidi_chain, peek, base_level);
+                    }
                 }
             }
 
@@ -334,30 +843,71 @@ void DetermineLevels(T&& code_points, BidiChain& bidi_chain, BidiLevel base_leve
 }
 
 
-BidiLink SkipIsolatingRun(const BidiChain& bidi_chain, BidiLink skip_link, BidiLink break_link)
-{
-    BidiLink link = skip_link;
-    size_t depth = 1;
-
-    while ((link = bidi_chain.GetNext(link)) != break_link) {
-        BidiType type = bidi_chain.GetType(link);
-
-        switch (type) {
-        case BidiType::LRI:
-        case BidiType::RLI:
-        case BidiType::FSI:
-            depth += 1;
-            break;
+/***
+ * Rule X10 with the isolating run sequences in the run queue resolved concurrently.  The level runs of each sequence
+ * are copied out of the queue first so that the queue is not shared.  Distinct sequences have no links in common and
+ * each thread attaches its sequences to its own sentinel rather than the roller, so the chain ends up the same as if
+ * the sequences had been resolved in order.
+ */
+template <typename Chain_t, typename Trace_t>
+void ResolveSequencesParallel(std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                              ChainWorkspace<Chain_t, Trace_t>& workspace,
+                              BidiLevel base_level) {
+    using link_type = typename Chain_t::link_type;
+
+    RunQueue<link_type>& run_queue = workspace.run_queue;
+    std::pmr::vector<LevelRun<link_type>>& sequence_runs = workspace.sequence_runs;
+    std::pmr::vector<size_t>& sequence_starts = workspace.sequence_starts;
+    sequence_runs.clear();
+    sequence_starts.clear();
+
+    for (; !run_queue.Empty(); run_queue.Dequeue()) {
+        LevelRun<link_type>& peek = run_queue.Peek();
+        if (IsRunKindAttached(peek.kind)) { continue; }
+        sequence_starts.push_back(sequence_runs.size());
+        for (LevelRun<link_type>* run = std::addressof(peek); run; run = run->next) { sequence_runs.push_back(*run); }
+    }
+    sequence_starts.push_back(sequence_runs.size());
+
+    // Link the copies of each sequence now that they no longer move.
+    size_t count = sequence_starts.size() - 1;
+    for (size_t sequence = 0; sequence < count; ++sequence) {
+        size_t last = sequence_starts[sequence + 1] - 1;
+        for (size_t index = sequence_starts[sequence]; index < last; ++index) {
+            sequence_runs[index].next = std::addressof(sequence_runs[index + 1]);
+        }
+        sequence_runs[last].next = nullptr;
+    }
 
-        case BidiType::PDI:
-            if (--depth == 0) {
-                return link;
-            }
-            break;
+    size_t threads = std::min(workspace.threads, count);
+    if (workspace.isolating_runs.size() < threads) { workspace.isolating_runs.resize(threads); }
+    if constexpr (Trace_t::ENABLED) {
+        if (workspace.thread_traces.size() < threads) { workspace.thread_traces.resize(threads); }
+    }
+    jcu::ParallelFor(count, threads, [&](size_t worker, size_t sequence) {
+        Trace_t* trace = std::addressof(workspace.trace);
+        if constexpr (Trace_t::ENABLED) { trace = std::addressof(workspace.thread_traces[worker]); }
+        workspace.isolating_runs[worker].Resolve(*trace,
+                                                 bracket_tags,
+                                                 workspace.bidi_chain,
+                                                 sequence_runs[sequence_starts[sequence]],
+                                                 base_level,
+                                                 workspace.bidi_chain.Sentinel(worker));
+    });
+    if constexpr (Trace_t::ENABLED) {
+        for (size_t worker = 0; worker < threads; ++worker) {
+            workspace.trace.Add(workspace.thread_traces[worker]);
+            workspace.thread_traces[worker].Reset();
         }
     }
+}
+
 
-    return BIDI_LINK_NONE;
+/* Matching PDI of the isolate initiated at skip_link or LINK_NONE if it is not terminated. */
+template <typename Chain_t>
+typename Chain_t::link_type SkipIsolatingRun(IsolatePairs<Chain_t>& isolate_pairs, typename Chain_t::link_type skip_link)
+{
+    return isolate_pairs.Find(skip_link).terminator;
 }
 
 
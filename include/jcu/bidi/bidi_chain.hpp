@@ -3,7 +3,10 @@
 #pragma once
 
 
+#include <concepts>
 #include <cstdint>
+#include <limits>
+#include <memory_resource>
 #include <span>
 #include <vector>
 
@@ -17,55 +20,149 @@ namespace jcu::bidi {
 using BidiLink = uint32_t;
 
 
-constexpr BidiLink BIDI_LINK_NONE = 0xFFFFFFFF;
+/***
+ * Links index the code units of a paragraph (plus the roller and the terminating link).  A 16-bit link halves the
+ * size of the links for the typical short string; 32-bit links are used for everything else.
+ */
+template <typename T>
+concept BidiLink_c = std::same_as<T, uint16_t> || std::same_as<T, uint32_t>;
+
+template <BidiLink_c Link_t>
+constexpr Link_t BidiLinkNone = std::numeric_limits<Link_t>::max();
+
+
+constexpr BidiLink BIDI_LINK_NONE = BidiLinkNone<BidiLink>;
 constexpr size_t INVALID_INDEX = 0xFFFFFFFF; // -1
 
 
 constexpr auto BidiChainGetOffset(auto link) noexcept { return link - 1; }
 
 
-struct BidiChain {
-    std::vector<BidiType> types{};
-    std::vector<BidiLevel> levels{};
-    std::vector<BidiLink> links{};
-    BidiLink last{0};
-
-    BidiChain(std::span<const BidiType> bidi_types) {
-        types = std::vector<BidiType>(bidi_types.size() + 2, BidiType::NIL);
-        levels = std::vector<BidiLevel>(bidi_types.size() + 2, LEVEL_TYPE_INVALID);
-        links = std::vector<BidiLink>(bidi_types.size() + 2, BIDI_LINK_NONE);
-        Populate(bidi_types);
+/***
+ * Memory layout of the chain.
+ *     SEPARATE    - types, levels and links are held in three arrays.
+ *     INTERLEAVED - type, level and link of each code unit are held together in one array of structs which keeps the
+ *                   data touched by a chain walk on the same cache line.
+ */
+enum class BidiChainLayout : uint8_t {
+    SEPARATE,
+    INTERLEAVED
+};
+
+
+template <BidiLink_c Link_t, BidiChainLayout Layout>
+class BidiChainStorage;
+
+
+template <BidiLink_c Link_t>
+class BidiChainStorage<Link_t, BidiChainLayout::SEPARATE> {
+    std::pmr::vector<BidiType> types{};
+    std::pmr::vector<BidiLevel> levels{};
+    std::pmr::vector<Link_t> links{};
+
+public:
+    BidiChainStorage() = default;
+    explicit BidiChainStorage(std::pmr::memory_resource* resource)
+        : types{resource}, levels{resource}, links{resource} {}
+
+    void Assign(size_t size) {
+        types.assign(size, BidiType::NIL);
+        levels.assign(size, LEVEL_TYPE_INVALID);
+        links.assign(size, BidiLinkNone<Link_t>);
     }
 
-    const BidiLink Roller() const noexcept { return 0; }
-    BidiType GetType(BidiLink link) const { return types[link]; }
-    BidiLevel GetLevel(BidiLink link) const { return levels[link]; }
-    BidiLink GetNext(BidiLink link) const { return links[link]; }
+    BidiType& Type(Link_t link) { return types[link]; }
+    BidiLevel& Level(Link_t link) { return levels[link]; }
+    Link_t& Next(Link_t link) { return links[link]; }
+    BidiType Type(Link_t link) const { return types[link]; }
+    BidiLevel Level(Link_t link) const { return levels[link]; }
+    Link_t Next(Link_t link) const { return links[link]; }
+};
 
-    void SetType(BidiLink link, BidiType type) { types[link] = type; }
-    void SetLevel(BidiLink link, BidiLevel level) { levels[link] = level; }
-    void SetNext(BidiLink link, BidiLink next) { links[link] = next; }
 
-    void AbandonNext(BidiLink link) {
-        BidiLink next = links[link];
-        BidiLink limit = links[next];
-        links[link] = limit;
+template <BidiLink_c Link_t>
+class BidiChainStorage<Link_t, BidiChainLayout::INTERLEAVED> {
+    struct Node {
+        Link_t next;
+        BidiType type;
+        BidiLevel level;
+    };
+
+    std::pmr::vector<Node> nodes{};
+
+public:
+    BidiChainStorage() = default;
+    explicit BidiChainStorage(std::pmr::memory_resource* resource) : nodes{resource} {}
+
+    void Assign(size_t size) {
+        nodes.assign(size, Node{.next=BidiLinkNone<Link_t>, .type=BidiType::NIL, .level=LEVEL_TYPE_INVALID});
+    }
+
+    BidiType& Type(Link_t link) { return nodes[link].type; }
+    BidiLevel& Level(Link_t link) { return nodes[link].level; }
+    Link_t& Next(Link_t link) { return nodes[link].next; }
+    BidiType Type(Link_t link) const { return nodes[link].type; }
+    BidiLevel Level(Link_t link) const { return nodes[link].level; }
+    Link_t Next(Link_t link) const { return nodes[link].next; }
+};
+
+
+template <BidiLink_c Link_t=BidiLink, BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+struct BidiChain {
+    using link_type = Link_t;
+
+    static constexpr link_type LINK_NONE = BidiLinkNone<link_type>;
+    // Number of code units addressable; the roller, the terminating link and LINK_NONE are reserved.
+    static constexpr size_t MAX_LENGTH = static_cast<size_t>(LINK_NONE) - 2;
+
+    BidiChainStorage<link_type, Layout> storage{};
+    link_type last{0};
+
+    BidiChain() = default;
+    explicit BidiChain(std::pmr::memory_resource* resource) : storage{resource} {}
+    BidiChain(std::span<const BidiType> bidi_types) { Assign(bidi_types); }
+
+    /***
+     * Rebuild the chain for bidi_types; the storage is reused and only grows.  sentinels extra links are kept past the
+     * terminating link, each of which can stand in for the roller of one thread (see Sentinel).
+     */
+    void Assign(std::span<const BidiType> bidi_types, size_t sentinels=0) {
+        storage.Assign(bidi_types.size() + 2 + sentinels);
+        last = 0;
+        Populate(bidi_types);
+    }
+
+    const link_type Roller() const noexcept { return 0; }
+    /* Private roller of a thread resolving isolating runs concurrently with others; a NIL link like the roller. */
+    link_type Sentinel(size_t thread) const noexcept { return last + 1 + static_cast<link_type>(thread); }
+    BidiType GetType(link_type link) const { return storage.Type(link); }
+    BidiLevel GetLevel(link_type link) const { return storage.Level(link); }
+    link_type GetNext(link_type link) const { return storage.Next(link); }
+
+    void SetType(link_type link, BidiType type) { storage.Type(link) = type; }
+    void SetLevel(link_type link, BidiLevel level) { storage.Level(link) = level; }
+    void SetNext(link_type link, link_type next) { storage.Next(link) = next; }
+
+    void AbandonNext(link_type link) {
+        link_type next = storage.Next(link);
+        link_type limit = storage.Next(next);
+        storage.Next(link) = limit;
     }
 
     void Add(BidiType type, size_t length) {
-        BidiLink current = last + static_cast<BidiLink>(length);
-        types[current] = type;
-        links[current] = Roller();
-        links[last] = current;
+        link_type current = last + static_cast<link_type>(length);
+        storage.Type(current) = type;
+        storage.Next(current) = Roller();
+        storage.Next(last) = current;
         last = current;
     }
 
-    bool IsSingle(BidiLink link) {
-        BidiLink next = links[link];
+    bool IsSingle(link_type link) const {
+        link_type next = storage.Next(link);
 
         /* Check the type of in between code units. */
         while (++link != next) {
-            if (types[link] != BidiType::BN) {
+            if (storage.Type(link) != BidiType::BN) {
                 return false;
             }
         }
@@ -73,9 +170,9 @@ struct BidiChain {
         return true;
     }
 
-    bool MergeIfEqual(BidiLink first, BidiLink second) {
-        if (types[first] == types[second] && levels[first] == levels[second]) {
-            links[first] = links[second];
+    bool MergeIfEqual(link_type first, link_type second) {
+        if (storage.Type(first) == storage.Type(second) && storage.Level(first) == storage.Level(second)) {
+            storage.Next(first) = storage.Next(second);
             return true;
         }
         return false;
@@ -89,6 +186,8 @@ struct BidiChain {
         for (; index < bidi_types.size(); ++index) {
             BidiType prior_type = type;
             type = bidi_types[index];
+            // Every code unit keeps its type, not only the first one of a link; IsSingle looks at the ones in between.
+            storage.Type(static_cast<link_type>(index + 1)) = type;
 
             bool add_last = false;
 
@@ -3,91 +3,81 @@
 #pragma once
 
 
-#include <algorithm>
 #include <cassert>
-#include <deque>
-#include <ranges>
+#include <cstddef>
+#include <cstdint>
 
 #include "jcu/bidi/bidi_chain.hpp"
 #include "jcu/bidi/bidi_type.hpp"
+#include "jcu/bidi/ring_buffer.hpp"
 
 
 namespace jcu::bidi {
 
 
+template <BidiLink_c Link_t=BidiLink>
 class BracketQueue {
+    static constexpr Link_t LINK_NONE = BidiLinkNone<Link_t>;
+
     static constexpr size_t MAX_CAPACITY = 63;
 
     struct BracketQueueElement {
-        char32_t bracket;
-        BidiLink closing_link;
-        BidiLink opening_link;
-        BidiLink prior_strong_link;
+        uint8_t pair_id;    //< jcu::data::BidiBrackets pair ID of the opening bracket.
+        Link_t closing_link;
+        Link_t opening_link;
+        Link_t prior_strong_link;
         BidiType strong_type;
     };
 
-    std::deque<BracketQueueElement> elements{};
+    InplaceRingBuffer<BracketQueueElement, MAX_CAPACITY + 1> elements{};
     bool should_dequeue{false};
     BidiType direction{BidiType::NIL};
 
 public:
-    bool Empty() const noexcept { return elements.empty(); }
-    bool Full() const noexcept { return elements.size() >= BracketQueue::MAX_CAPACITY; }
-    BidiLink GetClosingLink() const { return elements.front().closing_link; }
-    BidiLink GetOpeningLink() const { return elements.front().opening_link; }
-    BidiLink GetPriorStrongLink() const { return elements.front().prior_strong_link; }
-    BidiType GetStrongType() const { return elements.front().strong_type; }
-    void Reset(BidiType new_direction) { elements.clear(); should_dequeue = false; direction = new_direction; }
+    bool Empty() const noexcept { return elements.Empty(); }
+    bool Full() const noexcept { return elements.Size() >= BracketQueue::MAX_CAPACITY; }
+    Link_t GetClosingLink() const { return elements[0].closing_link; }
+    Link_t GetOpeningLink() const { return elements[0].opening_link; }
+    Link_t GetPriorStrongLink() const { return elements[0].prior_strong_link; }
+    BidiType GetStrongType() const { return elements[0].strong_type; }
+    void Reset(BidiType new_direction) { elements.Clear(); should_dequeue = false; direction = new_direction; }
     bool ShouldDequeue() const noexcept { return should_dequeue; }
-    size_t Size() const noexcept { return elements.size(); }
-
-    void ClosePair(BidiLink closing_link, char32_t bracket_ch) {
-        char32_t canonical = bracket_ch;
-        switch (bracket_ch) {
-        case 0x232A:
-            canonical = 0x3009;
-            break;
-
-        case 0x3009:
-            canonical = 0x232A;
-            break;
-
-        default:
-            break;
+    size_t Size() const noexcept { return elements.Size(); }
+
+    /* Canonically equivalent brackets share a pair ID so matching is a single compare. */
+    void ClosePair(Link_t closing_link, uint8_t pair_id) {
+        // Search from the top (latest) of the queue for the matching opening bracket.
+        size_t index = elements.Size();
+        while (index--) {
+            BracketQueueElement& e = elements[index];
+            if (e.pair_id == pair_id && e.opening_link != LINK_NONE && e.closing_link == LINK_NONE) { break; }
         }
+        if (index == static_cast<size_t>(-1)) { return; }
 
-        auto v = elements | std::views::reverse;
-        auto it = std::ranges::find_if(v, [&bracket_ch, &canonical](auto& e) {
-            return e.opening_link != BIDI_LINK_NONE &&
-                   e.closing_link == BIDI_LINK_NONE &&
-                   (e.bracket == bracket_ch || e.bracket == canonical);
-        });
-
-        if (it != v.end()) {
-            it->closing_link = closing_link;
+        elements[index].closing_link = closing_link;
 
-            // Conditionally mark all subsequent (i.e. towards the top) elements opening_link to none.
-            for (auto& e : std::ranges::subrange(v.begin(), it)) {
-                if (e.opening_link != BIDI_LINK_NONE && e.closing_link == BIDI_LINK_NONE) {
-                    e.opening_link = BIDI_LINK_NONE;
-                }
+        // Conditionally mark all subsequent (i.e. towards the top) elements opening_link to none.
+        for (size_t i = index + 1; i < elements.Size(); ++i) {
+            BracketQueueElement& e = elements[i];
+            if (e.opening_link != LINK_NONE && e.closing_link == LINK_NONE) {
+                e.opening_link = LINK_NONE;
             }
-
-            // check if found element is the front of the queue.
-            if (it == std::prev(v.end())) { should_dequeue = true; }
         }
+
+        // check if found element is the front of the queue.
+        if (index == 0) { should_dequeue = true; }
     }
 
     void Dequeue() {
-        assert(!elements.empty());
-        elements.pop_front();
+        assert(!elements.Empty());
+        elements.PopFront();
     }
 
-    void Enqueue(BidiLink prior_strong_link, BidiLink opening_link, char32_t bracket_ch) {
+    void Enqueue(Link_t prior_strong_link, Link_t opening_link, uint8_t pair_id) {
         assert(!Full());
-        elements.push_back({
-            .bracket=bracket_ch,
-            .closing_link=BIDI_LINK_NONE,
+        elements.PushBack({
+            .pair_id=pair_id,
+            .closing_link=LINK_NONE,
             .opening_link=opening_link,
             .prior_strong_link=prior_strong_link,
             .strong_type=BidiType::NIL
@@ -95,8 +85,9 @@ public:
     }
 
     void SetStrongType(BidiType strong_type) {
-        for (auto& e : elements) {
-            if (e.closing_link == BIDI_LINK_NONE && e.strong_type != direction) {
+        for (size_t i = 0; i < elements.Size(); ++i) {
+            BracketQueueElement& e = elements[i];
+            if (e.closing_link == LINK_NONE && e.strong_type != direction) {
                 e.strong_type = strong_type;
             }
         }
@@ -0,0 +1,235 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/constants.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/parallel.hpp"
+#include "jcu/ucd/bidi_character_test.hpp"
+#include "jcu/ucd/bidi_test.hpp"
+
+
+namespace jcu::bidi {
+
+
+namespace detail {
+
+
+/***
+ * Picks a code point of a given bidi class uniformly from all code points of that class.  BidiTest.txt lists classes
+ * rather than text, so each of its cases is given a text of code points sampled this way.
+ */
+class BidiTypeSampler {
+    struct Block {
+        char32_t code_point;
+        size_t index;   //< Index of code_point among all code points of its class.
+    };
+
+    std::unordered_map<BidiType, std::vector<Block>> blocks{};
+
+public:
+    BidiTypeSampler() {
+        std::unordered_map<BidiType, size_t> counts{};
+        auto begin = jcu::data::DerivedBidiClass::begin();
+        auto end = jcu::data::DerivedBidiClass::end();
+        for (auto it = begin; it != end && std::next(it) != end; ++it) {
+            size_t& count = counts[it->value];
+            blocks[it->value].push_back({.code_point=it->code_point, .index=count});
+            count += static_cast<size_t>(std::next(it)->code_point - it->code_point);
+        }
+
+        // Final index past the end for use with std::ranges::upper_bound.
+        for (auto& [type, type_blocks] : blocks) {
+            type_blocks.push_back({.code_point=jcu::CODE_POINT_INVALID, .index=counts[type]});
+        }
+    }
+
+    template <typename Generator_t>
+    char32_t operator()(BidiType type, Generator_t& generator) const {
+        const std::vector<Block>& type_blocks = blocks.at(type);
+        std::uniform_int_distribution<size_t> distribution{0, type_blocks.back().index - 1};
+        size_t index = distribution(generator);
+        auto block = std::ranges::prev(std::ranges::upper_bound(type_blocks, index, {}, &Block::index));
+        return block->code_point + static_cast<char32_t>(index - block->index);
+    }
+};
+
+
+}
+
+
+/***
+ * Result of BidiConformance::Resolve.  Per case vectors are indexed like BidiConformance::cases.
+ */
+struct BidiConformanceResult {
+    std::vector<uint8_t> passed{};
+    std::vector<uint64_t> nanoseconds{};    //< Fastest of the repeats of a case.
+    std::vector<std::string> errors{};      //< Message of the exception a case threw; empty otherwise.
+    std::chrono::nanoseconds elapsed{};     //< Wall time of the whole run.
+    size_t threads{1};
+
+    size_t Failures() const { return static_cast<size_t>(std::ranges::count(passed, uint8_t{0})); }
+};
+
+
+/***
+ * The cases of BidiTest.txt or BidiCharacterTest.txt parsed once into flat arrays, so that running them (repeatedly,
+ * e.g. as a benchmark) only resolves runs.  The text and expected levels of case i are the code points
+ * [cases[i].offset, cases[i].offset + cases[i].length) of text and levels.  A BidiTest.txt line is one case per
+ * paragraph direction it lists.
+ */
+class BidiConformance {
+public:
+    struct Case {
+        size_t offset{0};
+        size_t length{0};
+        BidiLevel base_level{LEVEL_TYPE_DEFAULT_AUTO};
+        size_t line_num{0};
+    };
+
+    std::vector<char32_t> text{};
+    std::vector<uint8_t> levels{};  //< jcu::ucd::LEVEL_REMOVED matches any level.
+    std::vector<Case> cases{};
+
+    /* Cases of BidiTest.txt in directory; the text of each is sampled by its bidi classes using seed. */
+    static BidiConformance FromBidiTest(const std::filesystem::path& directory, uint32_t seed) {
+        detail::BidiTypeSampler sampler{};
+        std::mt19937 generator{seed};
+        BidiConformance suite{};
+
+        for (auto&& [levels, reorders, values, direction_bitset, line_num] : jcu::ucd::BidiTestForwardView{directory}) {
+            if (levels.size() != values.size()) {
+                throw std::runtime_error{std::format("Line {} : Number of code points inconsistent.", line_num)};
+            }
+
+            std::vector<BidiLevel> base_levels{};
+            if (direction_bitset & jcu::ucd::BIDI_PROPS_DIRECTION_BIT_AUTO_LTR) {
+                base_levels.push_back(LEVEL_TYPE_DEFAULT_AUTO);
+            }
+            if (direction_bitset & jcu::ucd::BIDI_PROPS_DIRECTION_BIT_LTR) { base_levels.push_back(LEVEL_TYPE_LTR); }
+            if (direction_bitset & jcu::ucd::BIDI_PROPS_DIRECTION_BIT_RTL) { base_levels.push_back(LEVEL_TYPE_RTL); }
+            if (!(direction_bitset & jcu::ucd::BIDI_PROPS_DIRECTION_BIT_LTR) &&
+                (!direction_bitset || direction_bitset & ~7)) {
+                base_levels.push_back(LEVEL_TYPE_LTR);
+            }
+
+            for (BidiLevel base_level : base_levels) {
+                suite.cases.push_back({.offset=suite.text.size(), .length=values.size(), .base_level=base_level,
+                                       .line_num=line_num});
+                for (BidiType value : values) { suite.text.push_back(sampler(value, generator)); }
+                suite.levels.insert(suite.levels.end(), levels.begin(), levels.end());
+            }
+        }
+        return suite;
+    }
+
+    /* Cases of BidiCharacterTest.txt in directory. */
+    static BidiConformance FromBidiCharacterTest(const std::filesystem::path& directory) {
+        BidiConformance suite{};
+        for (auto&& unit : jcu::ucd::BidiCharacterTestForwardView{directory}) {
+            if (unit.levels.size() != unit.text.size()) {
+                throw std::runtime_error{std::format("Line {} : Number of code points inconsistent.", unit.line_num)};
+            }
+
+            BidiLevel base_level = LEVEL_TYPE_DEFAULT_AUTO;
+            if (unit.paragraph_direction == jcu::ucd::ParagraphDirection::LTR) {
+                base_level = LEVEL_TYPE_LTR;
+            } else if (unit.paragraph_direction == jcu::ucd::ParagraphDirection::RTL) {
+                base_level = LEVEL_TYPE_RTL;
+            }
+
+            suite.cases.push_back({.offset=suite.text.size(), .length=unit.text.size(), .base_level=base_level,
+                                   .line_num=unit.line_num});
+            suite.text.insert(suite.text.end(), unit.text.begin(), unit.text.end());
+            suite.levels.insert(suite.levels.end(), unit.levels.begin(), unit.levels.end());
+        }
+        return suite;
+    }
+
+    std::span<const char32_t> Text(const Case& test) const { return std::span{text}.subspan(test.offset, test.length); }
+
+    std::span<const uint8_t> Levels(const Case& test) const {
+        return std::span{levels}.subspan(test.offset, test.length);
+    }
+
+    /* True if runs, as resolved for the text of test, give every code point its expected level. */
+    bool Matches(const Case& test, std::span<const Run> runs, std::vector<uint8_t>& buffer) const {
+        buffer.assign(test.length, LEVEL_TYPE_INVALID);
+        for (const Run& run : runs) {
+            size_t first = std::min(run.offset, buffer.size());
+            size_t last = std::min(run.offset + run.length, buffer.size());
+            std::fill(buffer.begin() + first, buffer.begin() + last, run.level);
+        }
+        return std::ranges::equal(buffer, Levels(test), [](uint8_t actual, uint8_t expected) {
+            return expected == jcu::ucd::LEVEL_REMOVED || actual == expected;
+        });
+    }
+
+    /***
+     * Resolve and check every case, sharded over up to threads threads (0 for one per hardware thread) with one
+     * workspace per thread.  Each case is resolved repeats times and its fastest time kept, which makes the run the
+     * standard regression benchmark of ToRuns as well as the conformance test.  An exception fails only its case.
+     */
+    BidiConformanceResult Resolve(size_t threads=0, size_t repeats=1) const {
+        struct Worker {
+            BidiWorkspace<> workspace{};
+            std::vector<Run> runs{};
+            std::vector<uint8_t> buffer{};
+        };
+
+        BidiConformanceResult result{};
+        result.threads = threads ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+        result.passed.assign(cases.size(), 0);
+        result.nanoseconds.assign(cases.size(), 0);
+        result.errors.assign(cases.size(), {});
+        repeats = std::max<size_t>(1, repeats);
+
+        std::vector<Worker> workers(result.threads);
+        auto start = std::chrono::steady_clock::now();
+        jcu::ParallelFor(cases.size(), result.threads, [&](size_t worker_index, size_t index) {
+            Worker& worker = workers[worker_index];
+            const Case& test = cases[index];
+            try {
+                uint64_t fastest = std::numeric_limits<uint64_t>::max();
+                for (size_t repeat = 0; repeat < repeats; ++repeat) {
+                    worker.runs.clear();
+                    auto case_start = std::chrono::steady_clock::now();
+                    AppendRuns(worker.workspace, Text(test), test.base_level, worker.runs);
+                    std::chrono::nanoseconds case_elapsed = std::chrono::steady_clock::now() - case_start;
+                    fastest = std::min(fastest, static_cast<uint64_t>(case_elapsed.count()));
+                }
+                result.nanoseconds[index] = fastest;
+                result.passed[index] = Matches(test, worker.runs, worker.buffer);
+            } catch (const std::exception& e) {
+                result.errors[index] = e.what();
+            }
+        });
+        result.elapsed = std::chrono::steady_clock::now() - start;
+        return result;
+    }
+};
+
+
+}
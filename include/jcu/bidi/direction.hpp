@@ -0,0 +1,162 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <ranges>
+
+#include "jcu/allocation.hpp"
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/classify.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/utf/utf.hpp"
+
+
+namespace jcu::bidi {
+
+
+/* Direction of a paragraph given by its first strong character. */
+enum class BaseDirection : uint8_t {
+    NEUTRAL,    //< No strong character; the caller's default applies.
+    LTR,        //< First strong character is L (paragraph level 0).
+    RTL         //< First strong character is R or AL (paragraph level 1).
+};
+
+
+namespace detail {
+
+
+/***
+ * Rules P2 and P3 fed one bidi class at a time.  Isolate initiators are counted rather than matched to their PDI since
+ * everything up to the matching PDI is skipped either way, and an unmatched initiator skips the rest of the paragraph.
+ */
+class DirectionScan {
+    size_t isolates{0};
+
+public:
+    /* True once the direction is known and stored in direction; the scan ends at a strong type or a separator. */
+    constexpr bool Step(BidiType type, BaseDirection& direction) noexcept {
+        switch (type) {
+        case BidiType::L:
+            if (isolates) { return false; }
+            direction = BaseDirection::LTR;
+            return true;
+
+        case BidiType::R:
+        case BidiType::AL:
+            if (isolates) { return false; }
+            direction = BaseDirection::RTL;
+            return true;
+
+        case BidiType::LRI:
+        case BidiType::RLI:
+        case BidiType::FSI:
+            ++isolates;
+            return false;
+
+        case BidiType::PDI:
+            if (isolates) { --isolates; }
+            return false;
+
+        case BidiType::B:
+            direction = BaseDirection::NEUTRAL;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    constexpr bool InIsolate() const noexcept { return isolates != 0; }
+};
+
+
+/***
+ * Classify eight ASCII-or-not bytes at once.  SKIP: every byte is ASCII with no letter and no control character, so
+ * none is strong, an isolate control, or a paragraph separator.  LETTER: every byte is ASCII, none is a control
+ * character, and at least one is a letter (bidi class L).  MIXED: anything else, handled a code point at a time.
+ */
+enum class AsciiWord : uint8_t { SKIP, LETTER, MIXED };
+
+constexpr AsciiWord ClassifyAsciiWord(uint64_t word) noexcept {
+    constexpr uint64_t ONES = 0x0101010101010101;
+    constexpr uint64_t HIGH = 0x8080808080808080;
+    constexpr uint64_t LOW = 0x7F7F7F7F7F7F7F7F;
+
+    if (word & HIGH) { return AsciiWord::MIXED; }
+    if ((word - ONES * 0x20) & ~word & HIGH) { return AsciiWord::MIXED; }  // A byte below 0x20.
+
+    // Letters fold to 0x61..0x7A; a byte is within (0x60, 0x7B) when both of its range checks set the high bit.
+    uint64_t lower = word | (ONES * 0x20);
+    uint64_t letters = (ONES * (127 + 0x7B) - (lower & LOW)) & ~lower & ((lower & LOW) + ONES * (127 - 0x60)) & HIGH;
+    return letters ? AsciiWord::LETTER : AsciiWord::SKIP;
+}
+
+
+}
+
+
+/***
+ * Direction of the first paragraph of code_units by rules P2 and P3 alone: the direction of its first strong character
+ * (L, R or AL) outside of isolates, or NEUTRAL if there is none before the paragraph separator or the end of input.
+ * The scan stops at the first strong character, ASCII is classified by table without decoding, and contiguous UTF-8
+ * input skips eight bytes at a time through runs of ASCII digits, spaces and punctuation.  Much cheaper than ToRuns
+ * when only the alignment of a string is needed.  Ill-formed sequences are neutral (U+FFFD is ON).
+ */
+template <jcu::utf::IsCompatibleRange_c Range_t>
+BaseDirection DetectBaseDirection(Range_t&& code_units) {
+    JCU_ALLOCATION_API("jcu::bidi::DetectBaseDirection");
+    using Value_t = std::ranges::range_value_t<Range_t>;
+
+    detail::DirectionScan scan{};
+    jcu::detail::RangeLookup<jcu::data::DerivedBidiClass> bidi_lookup{};
+    BaseDirection direction = BaseDirection::NEUTRAL;
+
+    // One code point starting at it; returns true when the direction is known.
+    auto Step = [&](auto& it, const auto& end) -> bool {
+        char32_t unit = jcu::utf::Enlarge(*it);
+        if (unit < 0x80) {
+            ++it;
+            return scan.Step(jcu::detail::ASCII_TABLE<jcu::data::DerivedBidiClass>[unit], direction);
+        }
+
+        auto data = jcu::utf::Decode(it, end);
+        bool valid = data.error_code == jcu::utf::DecodeError::OK && jcu::utf::IsCodePointValid(data.code_point);
+        it = std::move(data.next);
+        return scan.Step(valid ? bidi_lookup(data.code_point) : BidiType::ON, direction);
+    };
+
+    auto it = std::ranges::begin(code_units);
+    auto end = std::ranges::end(code_units);
+
+    if constexpr (jcu::utf::IsUTF8Compatible_c<Value_t> && std::ranges::contiguous_range<Range_t> &&
+                  std::ranges::sized_range<Range_t>) {
+        while (it != end) {
+            if (end - it >= 8) {
+                uint64_t word = 0;
+                std::memcpy(&word, std::to_address(it), sizeof(word));
+                detail::AsciiWord kind = detail::ClassifyAsciiWord(word);
+                if (kind == detail::AsciiWord::LETTER && !scan.InIsolate()) { return BaseDirection::LTR; }
+                if (kind != detail::AsciiWord::MIXED) {
+                    it += 8;
+                    continue;
+                }
+            }
+            if (Step(it, end)) { return direction; }
+        }
+    } else {
+        while (it != end) {
+            if (Step(it, end)) { return direction; }
+        }
+    }
+
+    return BaseDirection::NEUTRAL;
+}
+
+
+}
@@ -0,0 +1,111 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/bidi/level.hpp"
+
+
+namespace jcu::bidi {
+
+
+/***
+ * Isolate initiators of a paragraph paired with their matching PDI (BD9) along with the first strong type found
+ * within each isolate and within the paragraph itself, skipping nested isolates (P2, P3).  Built in one linear pass
+ * over the chain before explicit levels are determined so that FSI resolution and isolate skipping are lookups
+ * instead of forward scans; nested FSIs would otherwise rescan the same text once per nesting level.
+ */
+template <typename Chain_t>
+class IsolatePairs {
+public:
+    using link_type = typename Chain_t::link_type;
+
+    struct IsolatePair {
+        link_type initiator;
+        link_type terminator;           //< Matching PDI or LINK_NONE when the isolate is not terminated.
+        BidiLevel first_strong_level;   //< 0 for L, 1 for R or AL, and LEVEL_TYPE_INVALID if there is none.
+    };
+
+private:
+    std::pmr::vector<IsolatePair> pairs{};
+    BidiLevel paragraph_level{LEVEL_TYPE_INVALID};
+    size_t cursor{0};
+    std::pmr::vector<size_t> open_isolates{};
+
+public:
+    IsolatePairs() = default;
+    explicit IsolatePairs(std::pmr::memory_resource* resource) : pairs{resource}, open_isolates{resource} {}
+    explicit IsolatePairs(const Chain_t& bidi_chain) { Assign(bidi_chain); }
+
+    /* Pair the isolates of bidi_chain, reusing the memory of any prior pairing. */
+    void Assign(const Chain_t& bidi_chain) {
+        pairs.clear();
+        open_isolates.clear();
+        paragraph_level = LEVEL_TYPE_INVALID;
+        cursor = 0;
+
+        const link_type roller = bidi_chain.Roller();
+
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            BidiType type = bidi_chain.GetType(link);
+
+            switch (type) {
+            case BidiType::L:
+            case BidiType::R:
+            case BidiType::AL:
+            {
+                BidiLevel& level = open_isolates.empty() ? paragraph_level
+                                                         : pairs[open_isolates.back()].first_strong_level;
+                if (level == LEVEL_TYPE_INVALID) { level = (type == BidiType::L) ? 0 : 1; }
+                break;
+            }
+
+            case BidiType::LRI:
+            case BidiType::RLI:
+            case BidiType::FSI:
+                open_isolates.push_back(pairs.size());
+                pairs.push_back({.initiator=link, .terminator=Chain_t::LINK_NONE, .first_strong_level=LEVEL_TYPE_INVALID});
+                break;
+
+            case BidiType::PDI:
+                if (!open_isolates.empty()) {
+                    pairs[open_isolates.back()].terminator = link;
+                    open_isolates.pop_back();
+                }
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+
+    /* First strong level of the paragraph outside of any isolate. */
+    BidiLevel GetParagraphLevel(BidiLevel default_level) const noexcept {
+        return paragraph_level == LEVEL_TYPE_INVALID ? default_level : paragraph_level;
+    }
+
+    /*
+     * Pair of the isolate initiator at link.  Lookups made in increasing link order, as DetermineLevels does, are
+     * constant time; anything else falls back to a binary search.
+     */
+    const IsolatePair& Find(link_type initiator) {
+        if (cursor >= pairs.size() || pairs[cursor].initiator > initiator) {
+            cursor = static_cast<size_t>(std::ranges::lower_bound(pairs, initiator, {}, &IsolatePair::initiator) -
+                                         pairs.begin());
+        }
+        while (cursor < pairs.size() && pairs[cursor].initiator < initiator) { ++cursor; }
+        assert(cursor < pairs.size() && pairs[cursor].initiator == initiator);
+        return pairs[cursor];
+    }
+};
+
+
+}
@@ -9,13 +9,14 @@
 #include <concepts>
 #include <deque>
 #include <ranges>
+#include <span>
 
 #include "jcu/bidi/bidi_chain.hpp"
 #include "jcu/bidi/bidi_type.hpp"
 #include "jcu/bidi/bracket_queue.hpp"
 #include "jcu/bidi/level_run.hpp"
+#include "jcu/bidi/trace.hpp"
 #include "jcu/data/bidi_brackets.hpp"
-#include "jcu/utf/concepts.hpp"
 
 
 namespace jcu::bidi {
@@ -25,39 +26,66 @@ constexpr BidiType LevelAsNormalBidiType(BidiLevel level) noexcept { return (lev
 constexpr BidiType LevelAsOppositeBidiType(BidiLevel level) noexcept { return (level & 1) ? BidiType::L : BidiType::R; }                              \
 
 
+template <typename Chain_t>
 class IsolatingRun {
-    BracketQueue bracket_queue{};
+    using link_type = typename Chain_t::link_type;
+
+    static constexpr link_type LINK_NONE = Chain_t::LINK_NONE;
+
+    BracketQueue<link_type> bracket_queue{};
+    link_type roller{0};    //< Link that starts and ends the isolating run while it is attached.
 
 public:
-    template <typename T>
-    requires jcu::utf::IsUTF32CompatibleReduced_c<std::ranges::range_value_t<T>>
-    void Resolve(T&& code_points, BidiChain& bidi_chain, LevelRun& base_level_run, BidiLevel base_level) {
+    /***
+     * Resolve the isolating run sequence starting with base_level_run.  The chain's roller links the sequence while it
+     * is resolved unless another link is given; a thread resolving sequences concurrently with others passes its own
+     * sentinel (see BidiChain::Sentinel) so that only the links of the sequence are written.
+     */
+    void Resolve(std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                 Chain_t& bidi_chain,
+                 LevelRun<link_type>& base_level_run,
+                 BidiLevel base_level,
+                 link_type sentinel=0) {
+        NoTrace trace{};
+        Resolve(trace, bracket_tags, bidi_chain, base_level_run, base_level, sentinel);
+    }
+
+    /* Same as above recording the phases of the sequence to trace (see BidiTrace). */
+    template <typename Trace_t>
+    void Resolve(Trace_t& trace,
+                 std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                 Chain_t& bidi_chain,
+                 LevelRun<link_type>& base_level_run,
+                 BidiLevel base_level,
+                 link_type sentinel=0) {
+        trace.Sequences();
+        roller = sentinel;
         // Save link for restoration at the end.
-        BidiLink original_link = bidi_chain.GetNext(bidi_chain.Roller());
+        link_type original_link = bidi_chain.GetNext(roller);
 
         /* Attach level run links to form isolating run. */
         /* Save last subsequent link. */
-        LevelRun* last_run = AttachLevelRunLinks(bidi_chain, base_level_run, base_level);
+        LevelRun<link_type>* last_run = AttachLevelRunLinks(bidi_chain, base_level_run, base_level);
 
         BidiType start_of_run = base_level_run.start_of_run;
         BidiType end_of_run = [&]() -> BidiType {
-            if (!IsRunKindPartialIsolate(base_level_run.kind)) { return last_run->end_of_run; }
+            if (!IsRunKindPartialIsolate(last_run->kind)) { return last_run->end_of_run; }
             BidiLevel eos_level = std::ranges::max(base_level_run.level, base_level);
             return (eos_level & 1) ? BidiType::R : BidiType::L;
         }();
-        BidiLink subsequent_link = last_run->subsequent_link;
+        link_type subsequent_link = last_run->subsequent_link;
 
         /* Rules W1-W7 */
-        BidiLink last_link = ResolveWeakTypes(bidi_chain, start_of_run);
+        link_type last_link = ResolveWeakTypes(bidi_chain, start_of_run, trace);
 
         /* Rule N0 */
-        ResolveBrackets(std::forward<T>(code_points), bidi_chain, base_level_run.level, start_of_run);
+        ResolveBrackets(bracket_tags, bidi_chain, base_level_run.level, start_of_run, trace);
 
         /* Rules N1, N2 */
-        ResolveNeutrals(bidi_chain, base_level_run.level, start_of_run, end_of_run);
+        ResolveNeutrals(bidi_chain, base_level_run.level, start_of_run, end_of_run, trace);
 
         /* Rules I1, I2 */
-        ResolveImplicitLevels(bidi_chain, base_level_run.level);
+        ResolveImplicitLevels(bidi_chain, base_level_run.level, trace);
 
         /* Re-attach original links. */
         AttachOriginalLinks(bidi_chain, base_level_run, original_link);
@@ -68,39 +96,39 @@ public:
     }
 
 private:
-    LevelRun* AttachLevelRunLinks(BidiChain& bidi_chain, LevelRun& base_level_run, BidiLevel base_level) {
-        bidi_chain.SetNext(bidi_chain.Roller(), base_level_run.first_link);
+    LevelRun<link_type>* AttachLevelRunLinks(Chain_t& bidi_chain, LevelRun<link_type>& base_level_run, BidiLevel base_level) {
+        bidi_chain.SetNext(roller, base_level_run.first_link);
 
         // Iterate over level runs and attach their links to form an isolating run.  Can be a chain longer than
         // one if run kind can be both an isolate and terminating.
-        LevelRun* current = std::addressof(base_level_run);
-        LevelRun* next = nullptr;
+        LevelRun<link_type>* current = std::addressof(base_level_run);
+        LevelRun<link_type>* next = nullptr;
         for (; (next = current->next); current = next) {
             bidi_chain.SetNext(current->last_link, next->first_link);
         }
-        bidi_chain.SetNext(current->last_link, bidi_chain.Roller());
+        bidi_chain.SetNext(current->last_link, roller);
 
         return current;
     }
 
-    void AttachOriginalLinks(BidiChain& bidi_chain, LevelRun& base_level_run, BidiLink original_link) {
-        bidi_chain.SetNext(bidi_chain.Roller(), original_link);
+    void AttachOriginalLinks(Chain_t& bidi_chain, LevelRun<link_type>& base_level_run, link_type original_link) {
+        bidi_chain.SetNext(roller, original_link);
 
         // Iterate over level runs and attach original subsequent links.
-        for (LevelRun* current = std::addressof(base_level_run); current; current = current->next) {
+        for (LevelRun<link_type>* current = std::addressof(base_level_run); current; current = current->next) {
             bidi_chain.SetNext(current->last_link, current->subsequent_link);
         }
     }
 
-    void ResolveAvailableBracketPairs(BidiChain& bidi_chain, BidiLevel run_level, BidiType start_of_run) {
+    void ResolveAvailableBracketPairs(Chain_t& bidi_chain, BidiLevel run_level, BidiType start_of_run) {
         BidiType embeddingDirection = LevelAsNormalBidiType(run_level);
         BidiType oppositeDirection = LevelAsOppositeBidiType(run_level);
 
         while (!bracket_queue.Empty()) {
-            BidiLink opening_link = bracket_queue.GetOpeningLink();
-            BidiLink closing_link = bracket_queue.GetClosingLink();
+            link_type opening_link = bracket_queue.GetOpeningLink();
+            link_type closing_link = bracket_queue.GetClosingLink();
 
-            if (opening_link != BIDI_LINK_NONE && closing_link != BIDI_LINK_NONE) {
+            if (opening_link != LINK_NONE && closing_link != LINK_NONE) {
                 BidiType pair_type = BidiType::NIL;
                 BidiType innerStrongType = bracket_queue.GetStrongType();
 
@@ -108,14 +136,14 @@ private:
                 if (innerStrongType == embeddingDirection) { pair_type = innerStrongType; }
                 /* Rule: N0.c */
                 else if (innerStrongType == oppositeDirection) {
-                    BidiLink prior_strong_link = bracket_queue.GetPriorStrongLink();
+                    link_type prior_strong_link = bracket_queue.GetPriorStrongLink();
                     BidiType priorStrongType = start_of_run;
 
-                    if (prior_strong_link != BIDI_LINK_NONE) {
+                    if (prior_strong_link != LINK_NONE) {
                         priorStrongType = bidi_chain.GetType(prior_strong_link);
                         if (IsBidiTypeNumber(priorStrongType)) { priorStrongType = BidiType::R; }
 
-                        BidiLink link = bidi_chain.GetNext(prior_strong_link);
+                        link_type link = bidi_chain.GetNext(prior_strong_link);
                         while (link != opening_link) {
                             BidiType type = bidi_chain.GetType(link);
                             if (type == BidiType::L || type == BidiType::R) { priorStrongType = type; }
@@ -142,13 +170,20 @@ private:
         }
     }
 
-    void ResolveBrackets(auto&& code_points, BidiChain& bidi_chain, BidiLevel run_level, BidiType start_of_run) {
-        const BidiLink roller = bidi_chain.Roller();
-        BidiLink prior_strong_link = BIDI_LINK_NONE;
+    /* Rule N0 with the brackets tagged up front (see jcu::Classify) so that pairing compares integers only. */
+    template <typename Trace_t>
+    void ResolveBrackets(std::span<const jcu::data::BidiBracketTag> bracket_tags,
+                         Chain_t& bidi_chain,
+                         BidiLevel run_level,
+                         BidiType start_of_run,
+                         Trace_t& trace) {
+        typename Trace_t::Scope scope{trace, BidiPhase::BRACKETS};
+        link_type prior_strong_link = LINK_NONE;
 
         bracket_queue.Reset(LevelAsNormalBidiType(run_level));
 
-        for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            trace.Work(BidiPhase::BRACKETS);
             BidiType type = bidi_chain.GetType(link);
 
             bool is_done = false;
@@ -156,22 +191,20 @@ private:
             switch (type) {
             case BidiType::ON:
             {
-                char32_t code_point = code_points.at(static_cast<size_t>(link - 1));
-                auto [paired_code_point, bracket_type] = jcu::data::BidiBrackets::Lookup(code_point);
-                switch (bracket_type) {
-                case jcu::data::BracketPairedType::OPEN:
+                assert(static_cast<size_t>(BidiChainGetOffset(link)) < bracket_tags.size());
+                jcu::data::BidiBracketTag tag = bracket_tags[BidiChainGetOffset(link)];
+                if (jcu::data::IsBidiBracketTagOpen(tag)) {
                     if (bracket_queue.Full()) { is_done = true; }
-                    else { bracket_queue.Enqueue(prior_strong_link, link, paired_code_point); }
-                    break;
-
-                case jcu::data::BracketPairedType::CLOSE:
-                    if (!bracket_queue.Empty()) {
-                        bracket_queue.ClosePair(link, code_point);
-                        if (bracket_queue.ShouldDequeue()) {
-                            ResolveAvailableBracketPairs(bidi_chain, run_level, start_of_run);
-                        }
+                    else {
+                        bracket_queue.Enqueue(prior_strong_link, link, jcu::data::BidiBracketTagPairId(tag));
+                        trace.Brackets();
+                        trace.BracketQueueSize(bracket_queue.Size());
+                    }
+                } else if (jcu::data::IsBidiBracketTagClose(tag) && !bracket_queue.Empty()) {
+                    bracket_queue.ClosePair(link, jcu::data::BidiBracketTagPairId(tag));
+                    if (bracket_queue.ShouldDequeue()) {
+                        ResolveAvailableBracketPairs(bidi_chain, run_level, start_of_run);
                     }
-                    break;
                 }
                 break;
             }
@@ -192,11 +225,13 @@ private:
         ResolveAvailableBracketPairs(bidi_chain, run_level, start_of_run);
     }
 
-    void ResolveImplicitLevels(BidiChain& bidi_chain, BidiLevel run_level) {
-        const BidiLink roller = bidi_chain.Roller();
+    template <typename Trace_t>
+    void ResolveImplicitLevels(Chain_t& bidi_chain, BidiLevel run_level, Trace_t& trace) {
+        typename Trace_t::Scope scope{trace, BidiPhase::IMPLICIT};
 
         if ((run_level & 1) == 0) {
-            for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+            for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+                trace.Work(BidiPhase::IMPLICIT);
                 BidiType type = bidi_chain.GetType(link);
                 assert(IsBidiTypeStrongOrNumber(type));
                 BidiLevel level = bidi_chain.GetLevel(link);
@@ -206,7 +241,8 @@ private:
                 else if (type != BidiType::L) { bidi_chain.SetLevel(link, level + 2); }
             }
         } else {
-            for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+            for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+                trace.Work(BidiPhase::IMPLICIT);
                 BidiType type = bidi_chain.GetType(link);
                 assert(IsBidiTypeStrongOrNumber(type));
                 BidiLevel level = bidi_chain.GetLevel(link);
@@ -217,12 +253,18 @@ private:
         }
     }
 
-    void ResolveNeutrals(BidiChain& bidi_chain, BidiLevel run_level, BidiType start_of_run, BidiType end_of_run) {
-        const BidiLink roller = bidi_chain.Roller();
+    template <typename Trace_t>
+    void ResolveNeutrals(Chain_t& bidi_chain,
+                         BidiLevel run_level,
+                         BidiType start_of_run,
+                         BidiType end_of_run,
+                         Trace_t& trace) {
+        typename Trace_t::Scope scope{trace, BidiPhase::NEUTRAL};
         BidiType strong_type = start_of_run;
-        BidiLink neutralLink = BIDI_LINK_NONE;
+        link_type neutralLink = LINK_NONE;
 
-        for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            trace.Work(BidiPhase::NEUTRAL);
             BidiType type = bidi_chain.GetType(link);
             assert(IsBidiTypeStrongOrNumber(type) || IsBidiTypeNeutralOrIsolate(type));
 
@@ -245,7 +287,7 @@ private:
             case BidiType::RLI:                         
             case BidiType::FSI:
             case BidiType::PDI:
-                if (neutralLink == BIDI_LINK_NONE) { neutralLink = link; }
+                if (neutralLink == LINK_NONE) { neutralLink = link; }
 
                 BidiType next_type = bidi_chain.GetType(bidi_chain.GetNext(link));
                 if (IsBidiTypeNumber(next_type))     { next_type = BidiType::R; }
@@ -260,20 +302,22 @@ private:
                         neutralLink = bidi_chain.GetNext(neutralLink);
                     } while (neutralLink != bidi_chain.GetNext(link));
 
-                    neutralLink = BIDI_LINK_NONE;
+                    neutralLink = LINK_NONE;
                 }
                 break;
             }
         }
     }
 
-    BidiLink ResolveWeakTypes(BidiChain& bidi_chain, BidiType start_of_run) {
-        const BidiLink roller = bidi_chain.Roller();
-        BidiLink prior_link = roller;
+    template <typename Trace_t>
+    link_type ResolveWeakTypes(Chain_t& bidi_chain, BidiType start_of_run, Trace_t& trace) {
+        typename Trace_t::Scope scope{trace, BidiPhase::WEAK};
+        link_type prior_link = roller;
         BidiType w1PriorType = start_of_run;
         BidiType w2StrongType = start_of_run;
 
-        for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            trace.Work(BidiPhase::WEAK);
             BidiType type = bidi_chain.GetType(link);
             bool force_merge = false;
 
@@ -313,6 +357,7 @@ private:
 
             if ((type != BidiType::ON && bidi_chain.GetType(prior_link) == type) || force_merge) {
                 bidi_chain.AbandonNext(prior_link);
+                trace.Merges();
             } else {
                 prior_link = link;
             }
@@ -323,16 +368,21 @@ private:
         BidiType w5PriorType = start_of_run;
         BidiType w7StrongType = start_of_run;
 
-        for (BidiLink link = bidi_chain.links[roller]; link != roller; link = bidi_chain.links[link]) {
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            trace.Work(BidiPhase::WEAK);
             BidiType type = bidi_chain.GetType(link);
             BidiType next_type = bidi_chain.GetType(bidi_chain.GetNext(link));
 
-            /* Rule W4 */
-            if (bidi_chain.IsSingle(link) &&
-                IsBidiTypeNumberSeparator(type) &&
+            /*
+             * Rule W4
+             * NOTE: IsSingle is checked last as it reads past the link up to the next one; for a separator between two
+             *       numbers those code units are part of this isolating run.
+             */
+            if (IsBidiTypeNumberSeparator(type) &&
                 IsBidiTypeNumber(w4PriorType) &&
                 (w4PriorType == next_type) &&
-                (w4PriorType == BidiType::EN || type == BidiType::CS))
+                (w4PriorType == BidiType::EN || type == BidiType::CS) &&
+                bidi_chain.IsSingle(link))
             {
                 /* Change the current type as well because it can be EN on which W5 depends. */
                 type = w4PriorType;
@@ -384,6 +434,7 @@ private:
 
             if (type != BidiType::ON && bidi_chain.GetType(prior_link) == type) {
                 bidi_chain.AbandonNext(prior_link);
+                trace.Merges();
             } else {
                 prior_link = link;
             }
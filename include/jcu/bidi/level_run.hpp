@@ -39,18 +39,26 @@ constexpr RunKind MakeRunKindAttached(RunKind k) noexcept { return k |= RunKindA
 constexpr RunKind MakeRunKindComplete(RunKind k) noexcept { return k &= ~RunKindPartial; }
 
 
+template <BidiLink_c Link_t=BidiLink>
 struct LevelRun {
+    using link_type = Link_t;
+
     LevelRun *next{nullptr};    //< Reference to the next sequence of run links. 
-    BidiLink first_link{0};       //< First link of the run. 
-    BidiLink last_link{0};        //< Last link of the run. 
-    BidiLink subsequent_link{0};  //< Subsequent link of the run. 
+    link_type first_link{0};       //< First link of the run. 
+    link_type last_link{0};        //< Last link of the run. 
+    link_type subsequent_link{0};  //< Subsequent link of the run. 
     BidiType start_of_run{BidiType::NIL};
     BidiType end_of_run{BidiType::NIL};
     RunKind kind{RunKindSimple};
     BidiLevel level{LEVEL_TYPE_INVALID};
 
     LevelRun() noexcept = default;
-    LevelRun(BidiChain& bidi_chain, BidiLink first_link, BidiLink last_link, BidiType start_of_run, BidiType end_of_run)
+    template <BidiChainLayout Layout>
+    LevelRun(const BidiChain<link_type, Layout>& bidi_chain,
+             link_type first_link,
+             link_type last_link,
+             BidiType start_of_run,
+             BidiType end_of_run)
     : first_link{first_link},
       last_link{last_link},
       subsequent_link{bidi_chain.GetNext(last_link)},
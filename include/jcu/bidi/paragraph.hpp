@@ -0,0 +1,376 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <inplace_vector>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "jcu/allocation.hpp"
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/bidi_chain.hpp"
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/bidi/isolating_run.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/level_run.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/data/bidi_brackets.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/utf/utf.hpp"
+
+
+namespace jcu::bidi {
+
+
+/***
+ * A paragraph that keeps its resolved levels between edits.  Insert and Erase re-resolve only the isolating run
+ * sequence enclosing the edit and keep the levels of everything else.  The whole paragraph is resolved again when
+ * the edit could change more than that:
+ *     - the paragraph contains explicit formatting other than LRI, RLI and PDI (embeddings, overrides, FSI), BN or
+ *       a paragraph separator
+ *     - the edit inserts or erases any explicit formatting character (isolates included), BN or a paragraph separator
+ *     - the isolates nest deeper than the maximum explicit level
+ *     - the paragraph level is determined automatically and the edit could change its first strong character
+ *
+ * Offsets are in code points.
+ */
+class BidiParagraph {
+public:
+    /***
+     * Result of an edit.  [offset, offset + length) is the range of code points (after the edit) whose levels may
+     * have changed and runs holds the indices into Runs() of the runs overlapping that range.
+     */
+    struct Change {
+        size_t offset{0};
+        size_t length{0};
+        bool full{false};   //< The whole paragraph was resolved again.
+        std::vector<size_t> runs{};
+    };
+
+private:
+    static constexpr size_t NO_INDEX = std::numeric_limits<size_t>::max();
+
+    std::vector<char32_t> code_points{};
+    std::vector<BidiType> bidi_types{};
+    std::vector<BidiLevel> explicit_levels{};   //< Levels from rules X1-X8; only valid when is_incremental.
+    std::vector<BidiLevel> levels{};            //< Resolved levels before rule L1.
+    std::vector<Run> runs{};
+    BidiLevel base_level{LEVEL_TYPE_DEFAULT_AUTO};
+    BidiLevel resolved_level{0};
+    size_t first_strong{NO_INDEX};              //< First strong character outside of isolates.
+    bool is_incremental{false};
+
+public:
+    BidiParagraph(BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) : base_level{base_level} {}
+
+    BidiParagraph(jcu::utf::IsCompatibleRange_c auto&& code_points_rng, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO)
+    : base_level{base_level}
+    {
+        jcu::utf::CodePointView view{std::forward<decltype(code_points_rng)>(code_points_rng)};
+        std::ranges::copy(view, std::back_inserter(code_points));
+        bidi_types.reserve(code_points.size());
+        std::ranges::transform(code_points, std::back_inserter(bidi_types), jcu::data::DerivedBidiClass::Lookup);
+        ResolveAll();
+    }
+
+    const std::vector<char32_t>& CodePoints() const noexcept { return code_points; }
+    const std::vector<BidiLevel>& Levels() const noexcept { return levels; }
+    BidiLevel ParagraphLevel() const noexcept { return resolved_level; }
+    const std::vector<Run>& Runs() const noexcept { return runs; }
+    size_t Size() const noexcept { return code_points.size(); }
+
+    Change Erase(size_t offset, size_t count) {
+        JCU_ALLOCATION_API("jcu::bidi::BidiParagraph::Erase");
+        if (offset > code_points.size() || count > code_points.size() - offset) {
+            throw std::out_of_range{std::format("Erase [{}, {}) is out of range for size {}",
+                                                offset, offset + count, code_points.size())};
+        }
+        if (count == 0) { return {.offset=offset}; }
+
+        std::span<const BidiType> erased{bidi_types.begin() + offset, count};
+        bool full = !is_incremental || std::ranges::any_of(erased, IsExplicit);
+        if (!full && base_level >= LEVEL_TYPE_MAX && first_strong != NO_INDEX && first_strong >= offset) {
+            if (first_strong < offset + count) { full = true; }
+            else { first_strong -= count; }
+        }
+        BidiLevel erased_level = full ? LEVEL_TYPE_INVALID : explicit_levels[offset];
+
+        auto Remove = [offset, count](auto& v) { v.erase(v.begin() + offset, v.begin() + offset + count); };
+        Remove(code_points);
+        Remove(bidi_types);
+        Remove(levels);
+        if (full) { return ResolveAll(); }
+        Remove(explicit_levels);
+
+        // The erased code points shared one explicit level; re-resolve the sequence they belonged to if anything of
+        // it is left on either side of the edit.
+        size_t anchor = NO_INDEX;
+        if (offset > 0 && explicit_levels[offset - 1] == erased_level) { anchor = offset - 1; }
+        else if (offset < explicit_levels.size() && explicit_levels[offset] == erased_level) { anchor = offset; }
+
+        return ResolveFrom(anchor, offset, 0);
+    }
+
+    Change Insert(size_t offset, jcu::utf::IsCompatibleRange_c auto&& code_points_rng) {
+        JCU_ALLOCATION_API("jcu::bidi::BidiParagraph::Insert");
+        if (offset > code_points.size()) {
+            throw std::out_of_range{std::format("Insert at {} is out of range for size {}", offset, code_points.size())};
+        }
+
+        std::vector<char32_t> inserted{};
+        jcu::utf::CodePointView view{std::forward<decltype(code_points_rng)>(code_points_rng)};
+        std::ranges::copy(view, std::back_inserter(inserted));
+        if (inserted.empty()) { return {.offset=offset}; }
+
+        std::vector<BidiType> inserted_types{};
+        inserted_types.reserve(inserted.size());
+        std::ranges::transform(inserted, std::back_inserter(inserted_types), jcu::data::DerivedBidiClass::Lookup);
+
+        bool full = !is_incremental || std::ranges::any_of(inserted_types, IsExplicit);
+        if (!full && base_level >= LEVEL_TYPE_MAX && (first_strong == NO_INDEX || offset <= first_strong)) {
+            if (std::ranges::any_of(inserted_types, IsBidiTypeStrong)) { full = true; }
+            else if (first_strong != NO_INDEX) { first_strong += inserted.size(); }
+        }
+
+        code_points.insert(code_points.begin() + offset, inserted.begin(), inserted.end());
+        bidi_types.insert(bidi_types.begin() + offset, inserted_types.begin(), inserted_types.end());
+        levels.insert(levels.begin() + offset, inserted.size(), LEVEL_TYPE_INVALID);
+        if (full) { return ResolveAll(); }
+
+        explicit_levels.insert(explicit_levels.begin() + offset, inserted.size(), InsertedLevel(offset));
+        return ResolveFrom(offset, offset, inserted.size());
+    }
+
+private:
+    static bool IsExplicit(BidiType type) noexcept {
+        return IsBidiTypeFormat(type) || type == BidiType::BN || type == BidiType::B;
+    }
+
+    static constexpr BidiLevel NextLevel(BidiType initiator, BidiLevel level) noexcept {
+        return initiator == BidiType::RLI ? ((level + 1) | 1) : ((level + 2) & ~1);
+    }
+
+    /* Explicit level of code points inserted at offset; the isolate-only explicit levels make it local. */
+    BidiLevel InsertedLevel(size_t offset) const noexcept {
+        if (offset == 0) { return resolved_level; }
+        BidiType prior = bidi_types[offset - 1];
+        BidiLevel prior_level = explicit_levels[offset - 1];
+        return IsBidiTypeIsolateInitiator(prior) ? NextLevel(prior, prior_level) : prior_level;
+    }
+
+    /***
+     * Explicit levels for a paragraph whose only explicit formatting characters are LRI, RLI and PDI along with the
+     * first strong character outside of isolates.  Returns false if the paragraph contains anything else, or the
+     * isolates overflow, in which case edits always resolve the whole paragraph.
+     */
+    bool DetermineIsolateLevels() {
+        explicit_levels.assign(bidi_types.size(), resolved_level);
+        first_strong = NO_INDEX;
+
+        std::inplace_vector<BidiLevel, LEVEL_TYPE_MAX + 2> stack{resolved_level};
+        for (size_t index = 0; index < bidi_types.size(); ++index) {
+            BidiType type = bidi_types[index];
+
+            switch (type) {
+            case BidiType::LRI:
+            case BidiType::RLI:
+            {
+                explicit_levels[index] = stack.back();
+                BidiLevel next_level = NextLevel(type, stack.back());
+                if (next_level > LEVEL_TYPE_MAX) { return false; }
+                stack.push_back(next_level);
+                break;
+            }
+
+            case BidiType::PDI:
+                if (stack.size() > 1) { stack.pop_back(); }
+                explicit_levels[index] = stack.back();
+                break;
+
+            default:
+                if (IsExplicit(type)) { return false; }
+                if (first_strong == NO_INDEX && stack.size() == 1 && IsBidiTypeStrong(type)) { first_strong = index; }
+                explicit_levels[index] = stack.back();
+                break;
+            }
+        }
+
+        return true;
+    }
+
+    Change ResolveAll() {
+        levels.assign(code_points.size(), LEVEL_TYPE_INVALID);
+        if (!code_points.empty()) {
+            resolved_level = ResolveLevels(code_points, bidi_types, base_level, levels);
+        } else if (base_level < LEVEL_TYPE_MAX) {
+            resolved_level = base_level;
+        } else {
+            resolved_level = base_level == LEVEL_TYPE_DEFAULT_RTL ? LEVEL_TYPE_RTL : LEVEL_TYPE_LTR;
+        }
+        is_incremental = DetermineIsolateLevels();
+        runs = CreateRuns(bidi_types, levels, resolved_level);
+
+        Change change{.offset=0, .length=code_points.size(), .full=true};
+        for (size_t i = 0; i < runs.size(); ++i) { change.runs.push_back(i); }
+        return change;
+    }
+
+    /***
+     * Re-resolve the isolating run sequence containing anchor (NO_INDEX for none) after an edit at offset that
+     * inserted inserted_count code points, rebuild the runs and report the change.
+     */
+    Change ResolveFrom(size_t anchor, size_t offset, size_t inserted_count) {
+        size_t first = offset;
+        size_t last = offset + inserted_count;
+
+        if (anchor != NO_INDEX) {
+            std::vector<size_t> sequence = IsolatingRunSequence(anchor);
+            std::vector<BidiLevel> resolved = ResolveSequence(sequence);
+            for (size_t i = 0; i < sequence.size(); ++i) {
+                size_t index = sequence[i];
+                if (levels[index] != resolved[i]) {
+                    levels[index] = resolved[i];
+                    first = std::ranges::min(first, index);
+                    last = std::ranges::max(last, index + 1);
+                }
+            }
+        }
+
+        runs = CreateRuns(bidi_types, levels, resolved_level);
+
+        // Rule L1 resets whitespace and isolates preceding a segment separator or the end of the line, so whether the
+        // ones just before the edit are reset may have changed along with it.
+        while (first > 0 && IsResetBeforeSeparator(bidi_types[first - 1])) { --first; }
+
+        Change change{.offset=first, .length=last - first, .full=false};
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (runs[i].offset < last && first < runs[i].offset + runs[i].length) { change.runs.push_back(i); }
+        }
+        return change;
+    }
+
+    static bool IsResetBeforeSeparator(BidiType type) noexcept {
+        return type == BidiType::WS || IsBidiTypeIsolate(type);
+    }
+
+    /* Index of the isolate initiator matching the PDI at index or NO_INDEX. */
+    size_t MatchingInitiator(size_t index) const {
+        size_t depth = 1;
+        while (index-- > 0) {
+            BidiType type = bidi_types[index];
+            if (type == BidiType::PDI) { ++depth; }
+            else if (IsBidiTypeIsolateInitiator(type) && --depth == 0) { return index; }
+        }
+        return NO_INDEX;
+    }
+
+    /* Index of the PDI matching the isolate initiator at index or NO_INDEX. */
+    size_t MatchingTerminator(size_t index) const {
+        size_t depth = 1;
+        while (++index < bidi_types.size()) {
+            BidiType type = bidi_types[index];
+            if (IsBidiTypeIsolateInitiator(type)) { ++depth; }
+            else if (type == BidiType::PDI && --depth == 0) { return index; }
+        }
+        return NO_INDEX;
+    }
+
+    /* Indices, in order, of the isolating run sequence (BD13) containing index. */
+    std::vector<size_t> IsolatingRunSequence(size_t index) const {
+        BidiLevel level = explicit_levels[index];
+        auto RunStart = [&](size_t i) { while (i > 0 && explicit_levels[i - 1] == level) { --i; } return i; };
+        auto RunEnd = [&](size_t i) {
+            while (i + 1 < explicit_levels.size() && explicit_levels[i + 1] == level) { ++i; }
+            return i + 1;
+        };
+
+        // Level runs as [start, end) pairs.
+        std::vector<std::pair<size_t, size_t>> level_runs{{RunStart(index), RunEnd(index)}};
+        while (true) {
+            size_t start = level_runs.front().first;
+            if (bidi_types[start] != BidiType::PDI) { break; }
+            size_t initiator = MatchingInitiator(start);
+            if (initiator == NO_INDEX) { break; }
+            level_runs.insert(level_runs.begin(), {RunStart(initiator), initiator + 1});
+        }
+        while (true) {
+            size_t end = level_runs.back().second;
+            if (!IsBidiTypeIsolateInitiator(bidi_types[end - 1])) { break; }
+            size_t terminator = MatchingTerminator(end - 1);
+            if (terminator == NO_INDEX) { break; }
+            level_runs.push_back({terminator, RunEnd(terminator)});
+        }
+
+        std::vector<size_t> sequence{};
+        for (auto [start, end] : level_runs) {
+            for (size_t i = start; i < end; ++i) { sequence.push_back(i); }
+        }
+        return sequence;
+    }
+
+    std::vector<BidiLevel> ResolveSequence(const std::vector<size_t>& sequence) const {
+        if (sequence.size() <= BidiChain<uint16_t>::MAX_LENGTH) { return ResolveSequence<BidiChain<uint16_t>>(sequence); }
+        return ResolveSequence<BidiChain<uint32_t>>(sequence);
+    }
+
+    /***
+     * Rules W1-I2 for a single isolating run sequence.  Its code points are gathered into their own chain at the
+     * sequence's explicit level and resolved as one level run with the sos and eos of the original sequence.
+     */
+    template <typename Chain_t>
+    std::vector<BidiLevel> ResolveSequence(const std::vector<size_t>& sequence) const {
+        using link_type = typename Chain_t::link_type;
+
+        std::vector<BidiType> sequence_types{};
+        std::vector<jcu::data::BidiBracketTag> sequence_bracket_tags{};
+        sequence_types.reserve(sequence.size());
+        sequence_bracket_tags.reserve(sequence.size());
+        for (size_t index : sequence) {
+            sequence_types.push_back(bidi_types[index]);
+            sequence_bracket_tags.push_back(ClassifyBracket(code_points[index], bidi_types[index]));
+        }
+
+        BidiLevel level = explicit_levels[sequence.front()];
+        BidiLevel prior_level = sequence.front() > 0 ? explicit_levels[sequence.front() - 1] : resolved_level;
+        size_t next = sequence.back() + 1;
+        BidiLevel next_level = next < explicit_levels.size() ? explicit_levels[next] : resolved_level;
+        BidiType start_of_run = LevelAsNormalBidiType(std::ranges::max(level, prior_level));
+        BidiType end_of_run = LevelAsNormalBidiType(std::ranges::max(level, next_level));
+
+        Chain_t bidi_chain{sequence_types};
+        const link_type roller = bidi_chain.Roller();
+        link_type last_link = roller;
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            bidi_chain.SetLevel(link, level);
+            if (link != bidi_chain.last) { last_link = link; }
+        }
+
+        LevelRun<link_type> level_run{bidi_chain, bidi_chain.GetNext(roller), last_link, start_of_run, end_of_run};
+        IsolatingRun<Chain_t> isolating_run{};
+        isolating_run.Resolve(sequence_bracket_tags, bidi_chain, level_run, resolved_level);
+
+        std::vector<BidiLevel> resolved(sequence.size(), level);
+        BidiLevel link_level = level;
+        size_t index = 0;
+        for (link_type link = bidi_chain.GetNext(roller); link != roller; link = bidi_chain.GetNext(link)) {
+            size_t offset = BidiChainGetOffset(link);
+            for (; index < offset; ++index) { resolved[index] = link_level; }
+            link_level = bidi_chain.GetLevel(link);
+        }
+        return resolved;
+    }
+};
+
+
+}
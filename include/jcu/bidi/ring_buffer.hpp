@@ -0,0 +1,142 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <inplace_vector>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+
+namespace jcu::bidi {
+
+
+/***
+ * FIFO ring buffer with a fixed capacity stored inline; never allocates.  Storage is an inplace_vector that grows
+ * until it reaches capacity N after which slots are reused.  N must be a power of two so indices wrap with a mask.
+ */
+template <typename T, size_t N>
+requires (std::has_single_bit(N))
+class InplaceRingBuffer {
+    std::inplace_vector<T, N> elements{};
+    size_t head{0};
+    size_t count{0};
+
+    static constexpr size_t Wrap(size_t index) noexcept { return index & (N - 1); }
+
+public:
+    static constexpr size_t Capacity() noexcept { return N; }
+
+    bool Empty() const noexcept { return count == 0; }
+    bool Full() const noexcept { return count == N; }
+    size_t Size() const noexcept { return count; }
+    void Clear() noexcept { head = 0; count = 0; }
+
+    T& operator[](size_t index) {
+        assert(index < count);
+        return elements[Wrap(head + index)];
+    }
+
+    const T& operator[](size_t index) const {
+        assert(index < count);
+        return elements[Wrap(head + index)];
+    }
+
+    T& Front() { return (*this)[0]; }
+    T& Back() { return (*this)[count - 1]; }
+
+    void PopFront() {
+        assert(!Empty());
+        head = Wrap(head + 1);
+        --count;
+    }
+
+    void PushBack(const T& value) {
+        assert(!Full());
+        size_t tail = Wrap(head + count);
+        if (tail == elements.size()) { elements.unchecked_push_back(value); }
+        else { elements[tail] = value; }
+        ++count;
+    }
+};
+
+
+/***
+ * FIFO ring buffer with contiguous, growable storage.  The storage doubles when full and is kept across Clear so a
+ * reused buffer stops allocating once it reaches its high-water mark.  Growing moves the elements; IndexOf can be used
+ * before growing to translate element addresses into logical indices that survive the move.  Storage comes from the
+ * memory resource given at construction.
+ */
+template <typename T>
+class RingBuffer {
+    std::pmr::vector<T> elements{};
+    size_t head{0};
+    size_t count{0};
+
+    size_t Wrap(size_t index) const noexcept { return index & (elements.size() - 1); }
+
+public:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    RingBuffer() = default;
+    explicit RingBuffer(std::pmr::memory_resource* resource) : elements{resource} {}
+
+    std::pmr::memory_resource* Resource() const noexcept { return elements.get_allocator().resource(); }
+    size_t Capacity() const noexcept { return elements.size(); }
+    bool Empty() const noexcept { return count == 0; }
+    bool Full() const noexcept { return count == elements.size(); }
+    size_t Size() const noexcept { return count; }
+    void Clear() noexcept { head = 0; count = 0; }
+
+    T& operator[](size_t index) {
+        assert(index < count);
+        return elements[Wrap(head + index)];
+    }
+
+    const T& operator[](size_t index) const {
+        assert(index < count);
+        return elements[Wrap(head + index)];
+    }
+
+    T& Front() { return (*this)[0]; }
+    T& Back() { return (*this)[count - 1]; }
+
+    /* Logical index of an element given its address. */
+    size_t IndexOf(const T* element) const noexcept {
+        assert(element >= elements.data() && element < elements.data() + elements.size());
+        return Wrap(static_cast<size_t>(element - elements.data()) + elements.size() - head);
+    }
+
+    void PopFront() {
+        assert(!Empty());
+        head = Wrap(head + 1);
+        --count;
+    }
+
+    /* Grow to at least new_capacity (rounded to a power of two) preserving the logical order of the elements. */
+    void Reserve(size_t new_capacity) {
+        new_capacity = std::bit_ceil(std::ranges::max(new_capacity, MIN_CAPACITY));
+        if (new_capacity <= elements.size()) { return; }
+
+        std::pmr::vector<T> storage(new_capacity, elements.get_allocator());
+        for (size_t i = 0; i < count; ++i) { storage[i] = std::move((*this)[i]); }
+        elements = std::move(storage);
+        head = 0;
+    }
+
+    template <typename U>
+    void PushBack(U&& value) {
+        if (Full()) { Reserve(elements.size() * 2); }
+        elements[Wrap(head + count)] = std::forward<U>(value);
+        ++count;
+    }
+};
+
+
+}
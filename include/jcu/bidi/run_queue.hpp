@@ -3,71 +3,101 @@
 #pragma once
 
 
-#include <algorithm>
-#include <array>
 #include <cassert>
 #include <concepts>
-#include <deque>
-#include <iterator>
+#include <cstddef>
+#include <inplace_vector>
+#include <limits>
+#include <memory_resource>
+#include <vector>
 
+#include "jcu/bidi/level.hpp"
 #include "jcu/bidi/level_run.hpp"
+#include "jcu/bidi/ring_buffer.hpp"
 
 
 namespace jcu::bidi {
 
 
+template <BidiLink_c Link_t=BidiLink>
 struct RunQueue {
-    std::deque<LevelRun> level_run_deque{};
-    ptrdiff_t partial_index{-1};
+    /*
+     * Every partial isolate in the queue is waiting on the terminating run of an isolate that is still open, so the
+     * number of them is bounded by the depth of the status stack.
+     */
+    static constexpr size_t MAX_PARTIAL_ISOLATES = LEVEL_TYPE_MAX + 2;
+
+    RingBuffer<LevelRun<Link_t>> level_runs{};
+    // Sequence numbers (enqueue order) of partial isolating runs; the top is the latest one.
+    std::inplace_vector<size_t, MAX_PARTIAL_ISOLATES> partial_isolates{};
+    size_t dequeued{0};
     bool should_dequeue{false};
 
+    RunQueue() = default;
+    explicit RunQueue(std::pmr::memory_resource* resource) : level_runs{resource} {}
+
+    void Clear() noexcept {
+        level_runs.Clear();
+        partial_isolates.clear();
+        dequeued = 0;
+        should_dequeue = false;
+    }
+
     void Dequeue() {
-        assert(!level_run_deque.empty());
-        level_run_deque.pop_front();
-        partial_index = std::ranges::max(static_cast<ptrdiff_t>(-1), partial_index - 1);
+        assert(!level_runs.Empty());
+        level_runs.PopFront();
+        if (!partial_isolates.empty() && partial_isolates.front() == dequeued) {
+            partial_isolates.erase(partial_isolates.begin());
+        }
+        ++dequeued;
     }
 
-    bool Empty() const noexcept { return level_run_deque.empty(); }
+    bool Empty() const noexcept { return level_runs.Empty(); }
+    size_t Size() const noexcept { return level_runs.Size(); }
 
     template <typename T>
-    requires std::same_as<LevelRun, std::remove_cvref_t<T>>
+    requires std::same_as<LevelRun<Link_t>, std::remove_cvref_t<T>>
     void Enqueue(T&& _level_run) {
-        if constexpr (std::movable<T>) {
-            level_run_deque.push_back(std::move(_level_run));
-        } else {
-            level_run_deque.push_back(_level_run);
-        }
+        if (level_runs.Full()) { Grow(); }
+        level_runs.PushBack(std::forward<T>(_level_run));
 
         // Can it be terminating and an isolate???
-        auto& level_run = level_run_deque.back();
-
-        // Complete the latest isolating run with this terminating run.
-        if (partial_index >= 0 && IsRunKindTerminating(level_run.kind)) {
-            auto it_partial = std::ranges::next(level_run_deque.begin(), partial_index, level_run_deque.end());
-
-            it_partial->Attach(level_run);
-
-            // find previous partial isolate run
-            auto rev_it = std::ranges::find_if(std::make_reverse_iterator(it_partial),
-                                               level_run_deque.rend(),
-                                               IsRunKindPartialIsolate, &LevelRun::kind);
-            if (rev_it != level_run_deque.rend()) {
-                partial_index = std::ranges::distance(level_run_deque.begin(), rev_it.base()) - 1;
-            } else {
-                partial_index = -1;
-                should_dequeue = false;
-            }
+        size_t sequence = dequeued + level_runs.Size() - 1;
+        LevelRun<Link_t>& level_run = level_runs.Back();
+
+        // Complete the latest isolating run with this terminating run; the previous partial isolate becomes the latest.
+        if (!partial_isolates.empty() && IsRunKindTerminating(level_run.kind)) {
+            level_runs[partial_isolates.back() - dequeued].Attach(level_run);
+            partial_isolates.pop_back();
+            if (partial_isolates.empty()) { should_dequeue = false; }
         }
 
         // Save the location of the isolating run.
         if (IsRunKindIsolate(level_run.kind)) {
-            partial_index = std::ssize(level_run_deque) - 1;
+            assert(partial_isolates.size() < MAX_PARTIAL_ISOLATES);
+            partial_isolates.push_back(sequence);
         }
     }
 
-    LevelRun& Peek() {
-        assert(!level_run_deque.empty());
-        return level_run_deque.front();
+    LevelRun<Link_t>& Peek() {
+        assert(!level_runs.Empty());
+        return level_runs.Front();
+    }
+
+private:
+    void Grow() {
+        // Attached runs point at each other; translate the links to logical indices before the storage moves.
+        static constexpr size_t NO_NEXT = std::numeric_limits<size_t>::max();
+        std::pmr::vector<size_t> next_indices(level_runs.Size(), NO_NEXT, level_runs.Resource());
+        for (size_t i = 0; i < level_runs.Size(); ++i) {
+            if (level_runs[i].next) { next_indices[i] = level_runs.IndexOf(level_runs[i].next); }
+        }
+
+        level_runs.Reserve(level_runs.Capacity() * 2);
+
+        for (size_t i = 0; i < next_indices.size(); ++i) {
+            if (next_indices[i] != NO_NEXT) { level_runs[i].next = std::addressof(level_runs[next_indices[i]]); }
+        }
     }
 };
 
@@ -4,8 +4,15 @@
 
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <limits>
 #include <ranges>
 #include <span>
+#include <stdexcept>
+#include <string_view>
 #include <vector>
 
 #include "jcu/bidi/bidi_type.hpp"
@@ -16,20 +23,36 @@ namespace jcu::bidi {
 
 
 struct Run;
+using OccurringLevels = std::array<bool, std::numeric_limits<BidiLevel>::max() + 1>;
+void CreateIndexMaps(std::span<const Run>, std::span<uint32_t>, std::span<uint32_t>);
 std::vector<Run> ProcessLevels(const std::vector<BidiLevel>&);
-void ReorderRuns(std::vector<Run>&, BidiLevel) ;
+void AppendLevelRuns(std::span<const BidiLevel>, std::vector<Run>&);
+template <typename T, typename Proj>
+void ReverseByLevel(std::span<T>, Proj, const OccurringLevels&);
+template <typename T, typename Proj=std::identity>
+void VisualOrder(std::span<const T>, std::span<uint32_t>, Proj={});
+void ReorderIndices(std::span<const BidiLevel>, std::span<uint32_t>);
+void ReorderRuns(std::span<Run>);
 template <typename R1, typename R2>
 requires (std::ranges::range<R1> &&
           std::ranges::range<R2> &&
           std::same_as<BidiType, std::ranges::range_value_t<R1>> &&
           std::same_as<BidiLevel, std::ranges::range_value_t<R2>>)
 std::vector<BidiLevel> ResetLevels(R1&&, R2&&, BidiLevel);
+template <typename R>
+requires (std::ranges::random_access_range<R> && std::same_as<BidiType, std::ranges::range_value_t<R>>)
+void ResetLevelsInPlace(R&&, std::span<BidiLevel>, BidiLevel);
+template <typename R, typename Allocator_t>
+requires (std::ranges::random_access_range<R> && std::same_as<BidiType, std::ranges::range_value_t<R>>)
+void FindResetRuns(R&&, BidiLevel, std::vector<Run, Allocator_t>&);
 
 
 struct Run {
     size_t offset{0};   //< The index to the first code unit of the run in source string.
     size_t length{0};   //< The number of code units covering the length of the run.
     BidiLevel level{0}; //< The embedding level of the run.
+
+    constexpr bool operator==(const Run&) const = default;
 };
 
 
@@ -41,13 +64,43 @@ requires (std::ranges::range<R1> &&
 std::vector<Run> CreateRuns(R1&& bidi_types, R2&& src_levels, BidiLevel base_level) {
     std::vector<BidiLevel> reset_levels = ResetLevels(bidi_types, src_levels, base_level);
     std::vector<Run> runs = ProcessLevels(reset_levels);
-    BidiLevel max_level = std::ranges::max(src_levels); // why original and not reset version?
-    ReorderRuns(runs, max_level);
+    ReorderRuns(runs);
     return runs;
 }
 
 
-std::vector<Run> ProcessLevels(const std::vector<BidiLevel>& levels) {
+/***
+ * Fill the logical-to-visual and visual-to-logical index maps from runs that are already in visual order (i.e. the
+ * output of CreateRuns).  Either map may be empty to skip it; otherwise it must hold at least one entry per index
+ * covered by the runs.  Runs at an odd level are laid out right-to-left so their indices are written in reverse.
+ */
+inline void CreateIndexMaps(std::span<const Run> runs,
+                            std::span<uint32_t> logical_to_visual,
+                            std::span<uint32_t> visual_to_logical) {
+    size_t total = 0;
+    for (const Run& run : runs) { total += run.length; }
+
+    auto CheckSize = [total](std::span<uint32_t> map, std::string_view name) {
+        if (!map.empty() && map.size() < total) {
+            throw std::out_of_range{std::format("{} map too small: {} < {}", name, map.size(), total)};
+        }
+    };
+    CheckSize(logical_to_visual, "Logical-to-visual");
+    CheckSize(visual_to_logical, "Visual-to-logical");
+
+    uint32_t visual = 0;
+    for (const Run& run : runs) {
+        bool is_rtl = run.level & 1;
+        for (size_t i = 0; i < run.length; ++i, ++visual) {
+            uint32_t logical = static_cast<uint32_t>(is_rtl ? run.offset + run.length - 1 - i : run.offset + i);
+            if (!logical_to_visual.empty()) { logical_to_visual[logical] = visual; }
+            if (!visual_to_logical.empty()) { visual_to_logical[visual] = logical; }
+        }
+    }
+}
+
+
+inline std::vector<Run> ProcessLevels(const std::vector<BidiLevel>& levels) {
     if (levels.empty()) { return {}; }
 
     // Alternative: Could allocate N, N/2, N/4 or some minimum; could be combined with shrink_to_fit
@@ -58,33 +111,181 @@ std::vector<Run> ProcessLevels(const std::vector<BidiLevel>& levels) {
     });
     runs.reserve(size_est);
 
-    runs.push_back({.offset=0, .length=1, .level=levels[0]});
-    for (auto const [index, level] : std::views::enumerate(levels) | std::views::drop(1)) {
-        Run& run = runs.back();
-        if (run.level != level) {
-            runs.push_back({.offset=static_cast<size_t>(index), .length=1, .level=level});
-        } else {
-            run.length++;
+    AppendLevelRuns(levels, runs);
+    return runs;
+}
+
+
+/* Append one run per maximal sequence of equal levels, in logical order, to runs. */
+inline void AppendLevelRuns(std::span<const BidiLevel> levels, std::vector<Run>& runs) {
+    if (levels.empty()) { return; }
+
+    size_t offset = 0;
+    for (size_t index = 1; index < levels.size(); ++index) {
+        if (levels[index] != levels[offset]) {
+            runs.push_back({.offset=offset, .length=index - offset, .level=levels[offset]});
+            offset = index;
         }
     }
+    runs.push_back({.offset=offset, .length=levels.size() - offset, .level=levels[offset]});
+}
 
-    return runs;
+
+/* Number of distinct levels up to which reversing in place beats building the visual order in a single pass. */
+constexpr size_t REORDER_IN_PLACE_MAX_LEVELS = 8;
+
+
+template <typename T, typename Proj>
+OccurringLevels FindOccurringLevels(std::span<T> elements, Proj proj) {
+    OccurringLevels occurring{};
+    for (const auto& element : elements) { occurring[std::invoke(proj, element)] = true; }
+    return occurring;
 }
 
 
-void ReorderRuns(std::vector<Run>& runs, BidiLevel max_level) {
-    for (BidiLevel newLevel = max_level; newLevel; newLevel--) {
-        size_t start = runs.size();
-        while (start--) {
-            if (runs[start].level >= newLevel) {
-                size_t count = 1;
-                for (; start && runs[start - 1].level >= newLevel; start--) {
-                    count += 1;
-                }
-                std::ranges::reverse(std::span{runs.begin() + start, count});
+/***
+ * Rule L2 in place: from the highest level down to the lowest odd level, reverse every maximal sequence of elements at
+ * that level or higher.  The sequences only change at levels that actually occur and reversing the same sequences
+ * twice is a no-op, so each occurring level is visited once and its sequences are reversed only when the distance to
+ * the next lower occurring level (or zero) is odd.  Cost is O(distinct levels x elements).
+ */
+template <typename T, typename Proj>
+void ReverseByLevel(std::span<T> elements, Proj proj, const OccurringLevels& occurring) {
+    size_t level = occurring.size() - 1;
+    while (level > 0) {
+        if (!occurring[level]) { --level; continue; }
+
+        size_t lower = level - 1;
+        while (lower > 0 && !occurring[lower]) { --lower; }
+
+        if ((level - lower) & 1) {
+            size_t start = 0;
+            while (start < elements.size()) {
+                if (std::invoke(proj, elements[start]) < level) { ++start; continue; }
+                size_t end = start + 1;
+                while (end < elements.size() && std::invoke(proj, elements[end]) >= level) { ++end; }
+                std::ranges::reverse(elements.subspan(start, end - start));
+                start = end;
             }
         }
+
+        level = lower;
+    }
+}
+
+
+/***
+ * Rule L2 in a single pass.  Reversing every maximal sequence at each level from the highest down to the lowest odd
+ * level is O(max level x elements); instead, maximal sequences are collected on a stack as the level sequence is
+ * scanned.  When a sequence at level q is closed by an element at a lower level it is reversed only if the number of
+ * levels between q and the level of the sequence it joins is odd.  Sequences are linked lists without orientation
+ * (each element knows its two neighbours but not which side is which) so that both reversing and joining are O(1).
+ *
+ * visual_to_logical[visual] receives the index of the element displayed at that position.
+ */
+template <typename T, typename Proj>
+void VisualOrder(std::span<const T> elements, std::span<uint32_t> visual_to_logical, Proj proj) {
+    static constexpr uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+    struct Sequence {
+        BidiLevel level;
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    if (visual_to_logical.size() < elements.size()) {
+        throw std::out_of_range{std::format("Visual-to-logical map too small: {} < {}",
+                                            visual_to_logical.size(), elements.size())};
+    }
+    if (elements.size() >= NONE) {
+        throw std::length_error{std::format("Too many elements to reorder: {}", elements.size())};
+    }
+    if (elements.empty()) { return; }
+
+    std::vector<std::array<uint32_t, 2>> neighbours(elements.size(), {NONE, NONE});
+    std::vector<Sequence> stack{};
+
+    auto Join = [&neighbours](Sequence& front, const Sequence& back) {
+        auto& front_tail = neighbours[front.tail];
+        auto& back_head = neighbours[back.head];
+        front_tail[front_tail[0] == NONE ? 0 : 1] = back.head;
+        back_head[back_head[0] == NONE ? 0 : 1] = front.tail;
+        front.tail = back.tail;
+    };
+
+    // Close every sequence above level; the remaining top of the stack is then at level or lower.
+    auto Close = [&stack, &Join](BidiLevel level) {
+        while (!stack.empty() && stack.back().level > level) {
+            Sequence closed = stack.back();
+            stack.pop_back();
+
+            bool join_top = !stack.empty() && stack.back().level >= level;
+            BidiLevel outer_level = join_top ? stack.back().level : level;
+            if ((closed.level - outer_level) & 1) { std::swap(closed.head, closed.tail); }
+
+            if (join_top) { Join(stack.back(), closed); }
+            else { stack.push_back({.level=level, .head=closed.head, .tail=closed.tail}); }
+        }
+    };
+
+    for (uint32_t index = 0; index < elements.size(); ++index) {
+        BidiLevel level = std::invoke(proj, elements[index]);
+        Close(level);
+
+        Sequence single{.level=level, .head=index, .tail=index};
+        if (!stack.empty() && stack.back().level == level) { Join(stack.back(), single); }
+        else { stack.push_back(single); }
+    }
+    Close(0);
+
+    Sequence line = stack.back();
+    if (line.level & 1) { std::swap(line.head, line.tail); }
+
+    uint32_t prior = NONE;
+    uint32_t current = line.head;
+    for (uint32_t& logical : visual_to_logical.first(elements.size())) {
+        logical = current;
+        uint32_t next = neighbours[current][0] == prior ? neighbours[current][1] : neighbours[current][0];
+        prior = current;
+        current = next;
+    }
+}
+
+
+/***
+ * Per-index visual order: visual_to_logical[visual] receives the logical index displayed at that position.  Levels
+ * are expected to have been through ResetLevels (L1).
+ */
+inline void ReorderIndices(std::span<const BidiLevel> levels, std::span<uint32_t> visual_to_logical) {
+    OccurringLevels occurring = FindOccurringLevels(levels, std::identity{});
+    if (static_cast<size_t>(std::ranges::count(occurring, true)) > REORDER_IN_PLACE_MAX_LEVELS) {
+        VisualOrder(levels, visual_to_logical);
+        return;
+    }
+
+    if (visual_to_logical.size() < levels.size()) {
+        throw std::out_of_range{std::format("Visual-to-logical map too small: {} < {}",
+                                            visual_to_logical.size(), levels.size())};
     }
+    std::span<uint32_t> order = visual_to_logical.first(levels.size());
+    for (uint32_t index = 0; index < order.size(); ++index) { order[index] = index; }
+    ReverseByLevel(order, [levels](uint32_t index) { return levels[index]; }, occurring);
+}
+
+
+/* Run order: reorder runs created from reset levels (L1) into visual order (L2). */
+inline void ReorderRuns(std::span<Run> runs) {
+    OccurringLevels occurring = FindOccurringLevels(runs, &Run::level);
+    if (static_cast<size_t>(std::ranges::count(occurring, true)) <= REORDER_IN_PLACE_MAX_LEVELS) {
+        ReverseByLevel(runs, &Run::level, occurring);
+        return;
+    }
+
+    std::vector<uint32_t> order(runs.size());
+    VisualOrder(std::span<const Run>{runs}, order, &Run::level);
+
+    std::vector<Run> logical{runs.begin(), runs.end()};
+    for (size_t visual = 0; visual < order.size(); ++visual) { runs[visual] = logical[order[visual]]; }
 }
 
 
@@ -95,7 +296,15 @@ requires (std::ranges::range<R1> &&
           std::same_as<BidiLevel, std::ranges::range_value_t<R2>>)
 std::vector<BidiLevel> ResetLevels(R1&& bidi_types, R2&& src_levels, BidiLevel base_level) {
     std::vector<BidiLevel> levels{src_levels.begin(), src_levels.end()};
+    ResetLevelsInPlace(bidi_types, levels, base_level);
+    return levels;
+}
+
 
+/* Rule L1 applied to levels in place; bidi_types are the original types of the paragraph. */
+template <typename R>
+requires (std::ranges::random_access_range<R> && std::same_as<BidiType, std::ranges::range_value_t<R>>)
+void ResetLevelsInPlace(R&& bidi_types, std::span<BidiLevel> levels, BidiLevel base_level) {
     size_t length = 0;
     bool reset = true;
 
@@ -109,7 +318,7 @@ std::vector<BidiLevel> ResetLevels(R1&& bidi_types, R2&& src_levels, BidiLevel b
         switch (type) {
         case BidiType::B:
         case BidiType::S:
-            std::ranges::fill(std::span{levels.begin() + index, length + 1}, base_level);
+            std::ranges::fill(levels.subspan(index, length + 1), base_level);
             length = 0;
             reset = true;
             break;
@@ -128,10 +337,8 @@ std::vector<BidiLevel> ResetLevels(R1&& bidi_types, R2&& src_levels, BidiLevel b
         case BidiType::RLI:
         case BidiType::FSI:
         case BidiType::PDI:
-            if (reset) {
-                std::ranges::fill(std::span{levels.begin() + index, length + 1}, base_level);
-                length = 0;
-            }
+            if (reset) { std::ranges::fill(levels.subspan(index, length + 1), base_level); }
+            length = 0;
             break;
 
         default:
@@ -140,8 +347,66 @@ std::vector<BidiLevel> ResetLevels(R1&& bidi_types, R2&& src_levels, BidiLevel b
             break;
         }
     }
+}
 
-    return levels;
+
+/***
+ * Rule L1 as the code units it resets rather than applied to a level per code unit: resets receives, in logical order,
+ * one run at base_level per maximal range of code units that ResetLevelsInPlace would reset.
+ */
+template <typename R, typename Allocator_t>
+requires (std::ranges::random_access_range<R> && std::same_as<BidiType, std::ranges::range_value_t<R>>)
+void FindResetRuns(R&& bidi_types, BidiLevel base_level, std::vector<Run, Allocator_t>& resets) {
+    resets.clear();
+    size_t length = 0;
+    bool reset = true;
+
+    // Ranges are found from the end; one that ends where the last one found starts extends it.
+    auto Reset = [&resets, base_level](size_t offset, size_t count) {
+        if (!resets.empty() && resets.back().offset == offset + count) {
+            resets.back().offset = offset;
+            resets.back().length += count;
+        } else {
+            resets.push_back({.offset=offset, .length=count, .level=base_level});
+        }
+    };
+
+    size_t index = std::ranges::size(bidi_types);
+    while (index--) {
+        switch (bidi_types[index]) {
+        case BidiType::B:
+        case BidiType::S:
+            Reset(index, length + 1);
+            length = 0;
+            reset = true;
+            break;
+
+        case BidiType::LRE:
+        case BidiType::RLE:
+        case BidiType::LRO:
+        case BidiType::RLO:
+        case BidiType::PDF:
+        case BidiType::BN:
+            length += 1;
+            break;
+
+        case BidiType::WS:
+        case BidiType::LRI:
+        case BidiType::RLI:
+        case BidiType::FSI:
+        case BidiType::PDI:
+            if (reset) { Reset(index, length + 1); }
+            length = 0;
+            break;
+
+        default:
+            length = 0;
+            reset = false;
+            break;
+        }
+    }
+
+    std::ranges::reverse(resets);
 }
 
 
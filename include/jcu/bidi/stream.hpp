@@ -0,0 +1,200 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "jcu/allocation.hpp"
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/bidi_chain.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/utf/utf.hpp"
+
+
+namespace jcu::bidi {
+
+
+/***
+ * Bidi over input that arrives in chunks (files, sockets, ranges too large to hold) one paragraph at a time.  Code
+ * units are split into paragraphs at paragraph separators (bidi class B, with CR LF kept together) and each paragraph
+ * is resolved as soon as its separator is seen.  Only the incomplete paragraph is buffered between writes and the
+ * workspace is reused, so memory is bounded by the longest paragraph rather than by the input.
+ */
+template <jcu::utf::IsCompatible_c Unit_t, BidiChainLayout Layout=BidiChainLayout::SEPARATE>
+class ParagraphStream {
+public:
+    struct Paragraph {
+        std::span<const Unit_t> text{};         //< Code units of the paragraph including its separator.
+        size_t offset{0};                       //< Offset of the paragraph's first code unit in the stream.
+        std::span<const Run> runs{};            //< Runs in visual order; offsets are relative to text.
+        BidiLevel level{LEVEL_TYPE_INVALID};    //< Paragraph embedding level.
+    };
+
+private:
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    BidiWorkspace<Layout> workspace{};
+    std::pmr::vector<Unit_t> pending{};  //< Code units of the incomplete paragraph carried over between writes.
+    size_t offset{0};                    //< Stream offset of the first pending code unit.
+    size_t scanned{0};                   //< Pending code units known not to end a paragraph.
+    BidiLevel base_level{LEVEL_TYPE_DEFAULT_AUTO};
+
+public:
+    explicit ParagraphStream(BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) : base_level{base_level} {}
+    /* Workspace and pending code units allocated from resource, e.g. an arena of the request reading the stream. */
+    ParagraphStream(std::pmr::memory_resource* resource, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO)
+        : workspace{resource}, pending{resource}, base_level{base_level} {}
+
+    /* Consume the next chunk of input; on_paragraph(const Paragraph&) is called for each paragraph completed by it. */
+    template <typename Callback_t>
+    void Write(std::span<const Unit_t> chunk, Callback_t&& on_paragraph) {
+        JCU_ALLOCATION_API("jcu::bidi::ParagraphStream::Write");
+        if (pending.empty()) {
+            // Paragraphs wholly inside the chunk are resolved in place; only the remainder is copied.
+            size_t consumed = Process(chunk, 0, on_paragraph);
+            pending.assign(chunk.begin() + consumed, chunk.end());
+            return;
+        }
+
+        pending.insert(pending.end(), chunk.begin(), chunk.end());
+        size_t consumed = Process(pending, scanned, on_paragraph);
+        pending.erase(pending.begin(), pending.begin() + consumed);
+    }
+
+    /* End of input: the remaining code units, if any, are the last paragraph. */
+    template <typename Callback_t>
+    void Finish(Callback_t&& on_paragraph) {
+        JCU_ALLOCATION_API("jcu::bidi::ParagraphStream::Finish");
+        if (!pending.empty()) {
+            Resolve(pending, on_paragraph);
+            offset += pending.size();
+            pending.clear();
+        }
+        scanned = 0;
+    }
+
+    /***
+     * Index one past the end of the paragraph separator at units[index] or NPOS if there is none.  A CR at the end of
+     * the units is only known to end a paragraph once the next code unit is known not to be a LF, or at the end of
+     * input (last).
+     */
+    static constexpr size_t SeparatorEnd(std::span<const Unit_t> units, size_t index, bool last) noexcept {
+        char32_t unit = jcu::utf::Enlarge(units[index]);
+        switch (unit) {
+        case 0x0A:
+        case 0x1C:
+        case 0x1D:
+        case 0x1E:
+            return index + 1;
+
+        case 0x0D:
+            if (index + 1 == units.size()) { return last ? index + 1 : NPOS; }
+            return jcu::utf::Enlarge(units[index + 1]) == 0x0A ? index + 2 : index + 1;
+        }
+
+        if constexpr (jcu::utf::IsUTF8Compatible_c<Unit_t>) {
+            // U+0085 is C2 85 and U+2029 is E2 80 A9; neither lead can be a trailing byte of another sequence.
+            if (unit == 0x85 && index >= 1 && jcu::utf::Enlarge(units[index - 1]) == 0xC2) { return index + 1; }
+            if (unit == 0xA9 && index >= 2 && jcu::utf::Enlarge(units[index - 2]) == 0xE2 &&
+                jcu::utf::Enlarge(units[index - 1]) == 0x80) { return index + 1; }
+        } else {
+            if (unit == 0x85 || unit == 0x2029) { return index + 1; }
+        }
+        return NPOS;
+    }
+
+private:
+    /* Resolve every paragraph of units completed at or after from; returns the number of code units consumed. */
+    template <typename Callback_t>
+    size_t Process(std::span<const Unit_t> units, size_t from, Callback_t& on_paragraph) {
+        size_t start = 0;
+        size_t index = from;
+        while (index < units.size()) {
+            if (!MayEndParagraph(units[index])) { ++index; continue; }
+
+            size_t end = SeparatorEnd(units, index, false);
+            if (end == NPOS) {
+                if (jcu::utf::Enlarge(units[index]) == 0x0D) { break; } // CR waiting on the next code unit.
+                ++index;
+                continue;
+            }
+
+            Resolve(units.subspan(start, end - start), on_paragraph);
+            offset += end - start;
+            start = end;
+            index = end;
+        }
+
+        scanned = index - start;
+        return start;
+    }
+
+    template <typename Callback_t>
+    void Resolve(std::span<const Unit_t> text, Callback_t& on_paragraph) {
+        workspace.runs.clear();
+        BidiLevel level = AppendRuns(workspace, text, base_level, workspace.runs);
+        std::invoke(on_paragraph, Paragraph{.text=text, .offset=offset, .runs=workspace.runs, .level=level});
+    }
+
+    /* Cheap filter for the last code unit of a paragraph separator. */
+    static constexpr bool MayEndParagraph(Unit_t unit) noexcept {
+        char32_t value = jcu::utf::Enlarge(unit);
+        return value == 0x0A || value == 0x0D || (value >= 0x1C && value <= 0x1E) || value == 0x85 ||
+               value == 0xA9 || value == 0x2029;
+    }
+};
+
+
+/* Resolve code_units paragraph by paragraph, calling on_paragraph as each one completes (see ParagraphStream). */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, std::ranges::input_range Range_t, typename Callback_t>
+requires jcu::utf::IsCompatibleRange_c<Range_t>
+void ForEachParagraph(Range_t&& code_units, Callback_t&& on_paragraph, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ForEachParagraph");
+    using Unit_t = std::ranges::range_value_t<Range_t>;
+
+    ParagraphStream<Unit_t, Layout> stream{base_level};
+    if constexpr (std::ranges::contiguous_range<Range_t> && std::ranges::sized_range<Range_t>) {
+        stream.Write(std::span<const Unit_t>{std::ranges::data(code_units), std::ranges::size(code_units)},
+                     on_paragraph);
+    } else {
+        std::vector<Unit_t> chunk(64 * 1024);
+        auto it = std::ranges::begin(code_units);
+        auto end = std::ranges::end(code_units);
+        while (it != end) {
+            size_t size = 0;
+            for (; size < chunk.size() && it != end; ++it) { chunk[size++] = *it; }
+            stream.Write(std::span<const Unit_t>{chunk.data(), size}, on_paragraph);
+        }
+    }
+    stream.Finish(on_paragraph);
+}
+
+
+/* Resolve UTF-8 read from in paragraph by paragraph, calling on_paragraph as each one completes. */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, typename Callback_t>
+void ForEachParagraph(std::istream& in, Callback_t&& on_paragraph, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ForEachParagraph");
+    ParagraphStream<char, Layout> stream{base_level};
+    std::vector<char> chunk(64 * 1024);
+    while (in) {
+        in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+        size_t size = static_cast<size_t>(in.gcount());
+        if (size == 0) { break; }
+        stream.Write(std::span<const char>{chunk.data(), size}, on_paragraph);
+    }
+    stream.Finish(on_paragraph);
+}
+
+
+}
@@ -0,0 +1,169 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+
+namespace jcu::bidi {
+
+
+/* Phases of resolving a paragraph as recorded by BidiTrace. */
+enum class BidiPhase : uint8_t {
+    CLASSIFY,   //< Bidi classes and bracket tags of the code units.
+    PARAGRAPH,  //< Building the chain and pairing isolates; rules P2, P3.
+    EXPLICIT,   //< Rules X1-X10 (DetermineLevels) apart from resolving the isolating run sequences.
+    WEAK,       //< Rules W1-W7.
+    BRACKETS,   //< Rule N0.
+    NEUTRAL,    //< Rules N1, N2.
+    IMPLICIT,   //< Rules I1, I2.
+    LINE,       //< Rule L1 and collecting the runs from the chain.
+    REORDER,    //< Rule L2 (ReorderRuns).
+    COUNT
+};
+
+
+constexpr std::array<std::string_view, static_cast<size_t>(BidiPhase::COUNT)> BIDI_PHASE_NAMES{
+    "classify", "paragraph", "explicit", "weak", "brackets", "neutral", "implicit", "line", "reorder"
+};
+
+
+struct PhaseTrace {
+    uint64_t calls{0};
+    uint64_t nanoseconds{0};    //< Not counting the phases entered from within this one.
+    /***
+     * Items visited: code units for CLASSIFY and PARAGRAPH, links for EXPLICIT to IMPLICIT and runs for LINE and
+     * REORDER.
+     */
+    uint64_t work{0};
+};
+
+
+/***
+ * Tracing policy of a BidiWorkspace that records nothing.  Its hooks are empty and inlined away, so an untraced
+ * workspace (the default) compiles to the same code as before tracing existed.
+ */
+struct NoTrace {
+    static constexpr bool ENABLED = false;
+
+    class Scope {
+    public:
+        constexpr Scope(NoTrace&, BidiPhase) noexcept {}
+    };
+
+    constexpr void Work(BidiPhase, uint64_t=1) noexcept {}
+    constexpr void Merges(uint64_t=1) noexcept {}
+    constexpr void Brackets(uint64_t=1) noexcept {}
+    constexpr void Sequences(uint64_t=1) noexcept {}
+    constexpr void RunQueueSize(size_t) noexcept {}
+    constexpr void BracketQueueSize(size_t) noexcept {}
+    constexpr void Add(const NoTrace&) noexcept {}
+    constexpr void Reset() noexcept {}
+};
+
+
+/***
+ * Tracing policy recording the time spent and the work done in each phase along with counts for the paragraph: links
+ * merged, brackets enqueued, isolating run sequences resolved and the high-water marks of the run and bracket queues.
+ * Use it to find the phase responsible when an input is slow, e.g.
+ *
+ *     BidiWorkspace<BidiChainLayout::SEPARATE, BidiTrace> workspace{};
+ *     AppendRuns(workspace, text, base_level, runs);
+ *     BidiTrace trace = workspace.Trace();
+ *     trace[BidiPhase::WEAK].nanoseconds;
+ *
+ * Each phase entered takes two clock reads.  Sequences resolved by worker threads (see ToRunsParallel) are traced per
+ * thread and summed, so their times are thread times rather than elapsed time.
+ */
+class BidiTrace {
+    using Clock = std::chrono::steady_clock;
+
+    std::array<PhaseTrace, static_cast<size_t>(BidiPhase::COUNT)> phases{};
+    BidiPhase active{BidiPhase::COUNT};     //< Phase being timed, COUNT when none.
+    Clock::time_point mark{};               //< Time the active phase was last charged to.
+
+public:
+    static constexpr bool ENABLED = true;
+
+    uint64_t merges{0};             //< Links merged into the prior link (X6-X9, W1-W7).
+    uint64_t brackets{0};           //< Opening brackets enqueued by N0.
+    uint64_t sequences{0};          //< Isolating run sequences resolved.
+    size_t run_queue_high_water{0};
+    size_t bracket_queue_high_water{0};
+
+    /* Times the enclosing block as phase; a nested scope pauses the one it is entered from. */
+    class Scope {
+        BidiTrace& trace;
+        BidiPhase outer;
+
+    public:
+        Scope(BidiTrace& trace, BidiPhase phase) : trace{trace}, outer{trace.Enter(phase)} {}
+        ~Scope() { trace.Leave(outer); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    const PhaseTrace& operator[](BidiPhase phase) const noexcept { return phases[static_cast<size_t>(phase)]; }
+
+    uint64_t TotalNanoseconds() const noexcept {
+        uint64_t total = 0;
+        for (const PhaseTrace& phase : phases) { total += phase.nanoseconds; }
+        return total;
+    }
+
+    void Work(BidiPhase phase, uint64_t count=1) noexcept { phases[static_cast<size_t>(phase)].work += count; }
+    void Merges(uint64_t count=1) noexcept { merges += count; }
+    void Brackets(uint64_t count=1) noexcept { brackets += count; }
+    void Sequences(uint64_t count=1) noexcept { sequences += count; }
+    void RunQueueSize(size_t size) noexcept { run_queue_high_water = std::max(run_queue_high_water, size); }
+    void BracketQueueSize(size_t size) noexcept { bracket_queue_high_water = std::max(bracket_queue_high_water, size); }
+
+    /* Accumulate the counts of other, e.g. of another thread or paragraph. */
+    void Add(const BidiTrace& other) noexcept {
+        for (size_t i = 0; i < phases.size(); ++i) {
+            phases[i].calls += other.phases[i].calls;
+            phases[i].nanoseconds += other.phases[i].nanoseconds;
+            phases[i].work += other.phases[i].work;
+        }
+        merges += other.merges;
+        brackets += other.brackets;
+        sequences += other.sequences;
+        run_queue_high_water = std::max(run_queue_high_water, other.run_queue_high_water);
+        bracket_queue_high_water = std::max(bracket_queue_high_water, other.bracket_queue_high_water);
+    }
+
+    /* Clear all counts; not while a phase is being timed. */
+    void Reset() noexcept { *this = BidiTrace{}; }
+
+private:
+    BidiPhase Enter(BidiPhase phase) noexcept {
+        Charge(Clock::now());
+        BidiPhase outer = active;
+        active = phase;
+        ++phases[static_cast<size_t>(phase)].calls;
+        return outer;
+    }
+
+    void Leave(BidiPhase outer) noexcept {
+        Charge(Clock::now());
+        active = outer;
+    }
+
+    void Charge(Clock::time_point now) noexcept {
+        if (active != BidiPhase::COUNT) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mark);
+            phases[static_cast<size_t>(active)].nanoseconds += static_cast<uint64_t>(elapsed.count());
+        }
+        mark = now;
+    }
+};
+
+
+}
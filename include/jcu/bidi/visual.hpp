@@ -0,0 +1,137 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "jcu/allocation.hpp"
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/bidi_chain.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/data/bidi_mirroring.hpp"
+#include "jcu/utf/utf.hpp"
+
+
+namespace jcu::bidi {
+
+
+/* Code unit of the visual string for input code units of type T; integer code units become the matching char type. */
+template <jcu::utf::IsCompatible_c T>
+using VisualUnit_t = std::conditional_t<std::same_as<T, char> || std::same_as<T, wchar_t> || jcu::utf::IsUTF_c<T>,
+                                        T,
+                                        jcu::utf::ConvertCompatible_t<T>>;
+
+
+/***
+ * Write the text of a paragraph in display order (rules L1, L2 and L4) to out and return the number of code units
+ * written.  Left-to-right runs are copied as is; right-to-left runs are written a code point at a time in reverse
+ * with characters that have a mirrored glyph replaced by it.  Ill-formed sequences are copied as is.  out must hold at
+ * least as many code units as the input; std::out_of_range is thrown otherwise.
+ */
+template <BidiChainLayout Layout, typename Trace_t, std::ranges::random_access_range Range_t, typename Unit_t>
+requires (jcu::utf::IsCompatibleRange_c<Range_t> &&
+          jcu::utf::IsCompatible_c<Unit_t> &&
+          sizeof(Unit_t) == sizeof(std::ranges::range_value_t<Range_t>))
+size_t ToVisualString(Range_t&& code_units,
+                      std::span<Unit_t> out,
+                      BidiWorkspace<Layout, Trace_t>& workspace,
+                      BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToVisualString");
+    using Value_t = std::ranges::range_value_t<Range_t>;
+    using Encoding_t = std::conditional_t<jcu::utf::IsUTF8Compatible_c<Value_t>, char8_t,
+                       std::conditional_t<jcu::utf::IsUTF32CompatibleReduced_c<Value_t>, char32_t, char16_t>>;
+    static constexpr char32_t NO_MIRROR = std::numeric_limits<char32_t>::max();
+
+    std::pmr::vector<Run>& runs = workspace.runs;
+    runs.clear();
+    AppendRuns(workspace, code_units, base_level, runs);
+
+    size_t length = static_cast<size_t>(std::ranges::distance(code_units));
+    if (out.size() < length) {
+        throw std::out_of_range{std::format("Visual string buffer too small: {} < {}", out.size(), length)};
+    }
+
+    auto units = std::ranges::begin(code_units);
+    auto Copy = [&](size_t offset, size_t count, size_t written) {
+        if constexpr (std::same_as<Value_t, Unit_t>) {
+            std::ranges::copy(units + offset, units + offset + count, out.begin() + written);
+        } else {
+            std::ranges::transform(units + offset, units + offset + count, out.begin() + written,
+                                   [](Value_t unit) { return static_cast<Unit_t>(unit); });
+        }
+    };
+
+    size_t written = 0;
+    for (const Run& run : runs) {
+        if (run.level & 1) {
+            // Decoded front to back, each code point is written to its mirrored place in the run.  A mirrored glyph
+            // encodes to as many code units as the character it replaces.
+            size_t end = run.offset + run.length;
+            for (size_t start = run.offset; start < end;) {
+                auto decoded = jcu::utf::Decode(units + start, units + end);
+                size_t next = static_cast<size_t>(decoded.next - units);
+                size_t target = written + (end - next);
+                char32_t mirror = jcu::data::BidiMirroring::Lookup(decoded.code_point);
+                if (mirror == NO_MIRROR) {
+                    Copy(start, next - start, target);
+                } else {
+                    auto encoded = jcu::utf::Encode<Encoding_t>(mirror);
+                    assert(encoded.size() == next - start);
+                    std::ranges::transform(encoded, out.begin() + target,
+                                           [](auto unit) { return static_cast<Unit_t>(unit); });
+                }
+                start = next;
+            }
+        } else {
+            Copy(run.offset, run.length, written);
+        }
+        written += run.length;
+    }
+
+    return written;
+}
+
+
+/* Same as above with a workspace of its own. */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, std::ranges::random_access_range Range_t, typename Unit_t>
+requires (jcu::utf::IsCompatibleRange_c<Range_t> &&
+          jcu::utf::IsCompatible_c<Unit_t> &&
+          sizeof(Unit_t) == sizeof(std::ranges::range_value_t<Range_t>))
+size_t ToVisualString(Range_t&& code_units, std::span<Unit_t> out, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToVisualString");
+    BidiWorkspace<Layout> workspace{};
+    return ToVisualString(std::forward<Range_t>(code_units), out, workspace, base_level);
+}
+
+
+/* Text of a paragraph in display order (rules L1, L2 and L4) as a new string. */
+template <BidiChainLayout Layout=BidiChainLayout::SEPARATE, std::ranges::random_access_range Range_t>
+requires jcu::utf::IsCompatibleRange_c<Range_t>
+std::basic_string<VisualUnit_t<std::ranges::range_value_t<Range_t>>>
+ToVisualString(Range_t&& code_units, BidiLevel base_level=LEVEL_TYPE_DEFAULT_AUTO) {
+    JCU_ALLOCATION_API("jcu::bidi::ToVisualString");
+    using Unit_t = VisualUnit_t<std::ranges::range_value_t<Range_t>>;
+
+    BidiWorkspace<Layout> workspace{};
+    std::basic_string<Unit_t> visual(static_cast<size_t>(std::ranges::distance(code_units)), Unit_t{});
+    visual.resize(ToVisualString(std::forward<Range_t>(code_units), std::span{visual}, workspace, base_level));
+    return visual;
+}
+
+
+}
@@ -0,0 +1,207 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/data/bidi_brackets.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/data/derived_general_category.hpp"
+#include "jcu/data/scripts.hpp"
+#include "jcu/general_category.hpp"
+#include "jcu/script.hpp"
+#include "jcu/utf/utf.hpp"
+
+
+namespace jcu {
+
+
+/***
+ * Caller provided property arrays (structure of arrays) filled by Classify.  An empty span means the property is not
+ * requested and is neither looked up nor written.
+ */
+struct ClassifyBuffers {
+    std::span<char32_t> code_points{};
+    std::span<jcu::bidi::BidiType> bidi_types{};
+    std::span<GeneralCategory> general_categories{};
+    std::span<Script> scripts{};
+    std::span<jcu::data::BidiBracketsUnit> brackets{};
+    std::span<jcu::data::BidiBracketTag> bracket_tags{};   //< Compact form of brackets for the bidi algorithm.
+};
+
+
+/***
+ * How Classify indexes its output.
+ *     CODE_POINT - one entry per decoded code point.
+ *     CODE_UNIT  - one entry per code unit of the input.  The first code unit of each code point holds its properties;
+ *                  the remaining ones hold code point 0, BN (so bidi rule X9 folds them into the first), no bracket,
+ *                  and repeat the general category and script of the first.
+ */
+enum class ClassifyIndex : uint8_t {
+    CODE_POINT,
+    CODE_UNIT
+};
+
+
+namespace detail {
+
+
+template <typename Table_t>
+constexpr auto MakeAsciiTable() noexcept {
+    std::array<typename Table_t::value_type, 0x80> table{};
+    for (char32_t code_point = 0; code_point < table.size(); ++code_point) { table[code_point] = Table_t::Lookup(code_point); }
+    return table;
+}
+
+
+template <typename Table_t>
+constexpr auto ASCII_TABLE = MakeAsciiTable<Table_t>();
+
+
+/***
+ * Lookup into a generated range table that remembers the last range found.  Text tends to stay within a script and
+ * so within the same few ranges; those lookups skip the binary search entirely.
+ */
+template <typename Table_t>
+class RangeLookup {
+public:
+    using value_type = typename Table_t::value_type;
+
+private:
+    char32_t first{0};
+    char32_t last{0};   //< One past the end of the cached range; first == last is empty.
+    value_type value{};
+
+public:
+    constexpr value_type operator()(char32_t code_point) noexcept {
+        if (code_point >= first && code_point < last) { return value; }
+
+        auto it = std::ranges::upper_bound(Table_t::begin(), Table_t::end(), code_point, {},
+                                           [](const auto& data) { return data.code_point; });
+        if (it == Table_t::begin()) { return Table_t::Lookup(code_point); }
+
+        first = std::ranges::prev(it)->code_point;
+        last = (it == Table_t::end()) ? jcu::utf::CODE_POINT_MAX + 1 : it->code_point;
+        value = std::ranges::prev(it)->value;
+        return value;
+    }
+};
+
+
+}
+
+
+/***
+ * Decode UTF-8, UTF-16 or UTF-32 input and write the requested properties of each code point in a single pass; the
+ * input is read once regardless of how many properties are requested.  ASCII skips both decoding and lookups, and the
+ * range tables cache the last range found.  Ill-formed sequences are classified one code unit at a time as U+FFFD.
+ *
+ * Every requested span must hold the number of entries produced, which is at most the number of code units of the
+ * input; std::length_error is thrown otherwise.  Returns the number of entries written.  CODE_UNIT indexing requires
+ * a forward range to count the code units consumed by each code point.
+ */
+template <ClassifyIndex Index=ClassifyIndex::CODE_POINT, jcu::utf::IsCompatibleRange_c Range_t>
+requires (Index == ClassifyIndex::CODE_POINT || std::ranges::forward_range<Range_t>)
+size_t Classify(Range_t&& code_units, const ClassifyBuffers& buffers) {
+    size_t capacity = std::numeric_limits<size_t>::max();
+    for (size_t size : {buffers.code_points.size(), buffers.bidi_types.size(), buffers.general_categories.size(),
+                        buffers.scripts.size(), buffers.brackets.size(), buffers.bracket_tags.size()}) {
+        if (size) { capacity = std::min(capacity, size); }
+    }
+
+    detail::RangeLookup<jcu::data::DerivedBidiClass> bidi_lookup{};
+    detail::RangeLookup<jcu::data::DerivedGeneralCategory> general_category_lookup{};
+    detail::RangeLookup<jcu::data::Scripts> script_lookup{};
+
+    auto Write = [&](size_t index, char32_t code_point) {
+        if (index >= capacity) [[unlikely]] {
+            throw std::length_error(std::format("Classify output of capacity {} is too small", capacity));
+        }
+        if (!buffers.code_points.empty()) { buffers.code_points[index] = code_point; }
+        if (code_point < 0x80) {
+            if (!buffers.bidi_types.empty()) {
+                buffers.bidi_types[index] = detail::ASCII_TABLE<jcu::data::DerivedBidiClass>[code_point];
+            }
+            if (!buffers.general_categories.empty()) {
+                buffers.general_categories[index] = detail::ASCII_TABLE<jcu::data::DerivedGeneralCategory>[code_point];
+            }
+            if (!buffers.scripts.empty()) {
+                buffers.scripts[index] = detail::ASCII_TABLE<jcu::data::Scripts>[code_point];
+            }
+            if (!buffers.brackets.empty()) {
+                buffers.brackets[index] = detail::ASCII_TABLE<jcu::data::BidiBrackets>[code_point];
+            }
+            if (!buffers.bracket_tags.empty()) {
+                buffers.bracket_tags[index] = jcu::data::MakeBidiBracketTag(
+                    detail::ASCII_TABLE<jcu::data::BidiBrackets>[code_point]);
+            }
+        } else {
+            if (!buffers.bidi_types.empty()) { buffers.bidi_types[index] = bidi_lookup(code_point); }
+            if (!buffers.general_categories.empty()) {
+                buffers.general_categories[index] = general_category_lookup(code_point);
+            }
+            if (!buffers.scripts.empty()) { buffers.scripts[index] = script_lookup(code_point); }
+            if (!buffers.brackets.empty()) { buffers.brackets[index] = jcu::data::BidiBrackets::Lookup(code_point); }
+            if (!buffers.bracket_tags.empty()) {
+                // Paired brackets are all bidi class ON; with the classes at hand the search is skipped for the rest.
+                bool maybe_bracket = buffers.bidi_types.empty() || buffers.bidi_types[index] == jcu::bidi::BidiType::ON;
+                buffers.bracket_tags[index] =
+                    maybe_bracket ? jcu::data::MakeBidiBracketTag(jcu::data::BidiBrackets::Lookup(code_point)) : 0;
+            }
+        }
+    };
+
+    auto WriteTrail = [&](size_t index, size_t lead) {
+        if (index >= capacity) [[unlikely]] {
+            throw std::length_error(std::format("Classify output of capacity {} is too small", capacity));
+        }
+        if (!buffers.code_points.empty()) { buffers.code_points[index] = 0; }
+        if (!buffers.bidi_types.empty()) { buffers.bidi_types[index] = jcu::bidi::BidiType::BN; }
+        if (!buffers.general_categories.empty()) {
+            buffers.general_categories[index] = buffers.general_categories[lead];
+        }
+        if (!buffers.scripts.empty()) { buffers.scripts[index] = buffers.scripts[lead]; }
+        if (!buffers.brackets.empty()) { buffers.brackets[index] = {}; }
+        if (!buffers.bracket_tags.empty()) { buffers.bracket_tags[index] = 0; }
+    };
+
+    size_t count = 0;
+    auto it = std::ranges::begin(code_units);
+    auto end = std::ranges::end(code_units);
+    while (it != end) {
+        char32_t unit = jcu::utf::Enlarge(*it);
+        if (unit < 0x80) {
+            Write(count++, unit);
+            ++it;
+            continue;
+        }
+
+        auto data = jcu::utf::Decode(it, end);
+        bool valid = data.error_code == jcu::utf::DecodeError::OK && jcu::utf::IsCodePointValid(data.code_point);
+        size_t lead = count;
+        Write(count++, valid ? data.code_point : jcu::utf::REPLACEMENT_CHARACTER);
+
+        if constexpr (Index == ClassifyIndex::CODE_UNIT) {
+            for (++it; it != data.next; ++it) { WriteTrail(count++, lead); }
+        } else {
+            it = std::move(data.next);
+        }
+    }
+
+    return count;
+}
+
+
+}
@@ -10,6 +10,7 @@
 #include <array>
 #include <limits>
 
+#include "jcu/perfect_hash.hpp"
 #include "jcu/unicode_version.hpp"
 
 
@@ -24,9 +25,9 @@ public:
     static constexpr auto end() noexcept { return data.cend(); }
 
     static constexpr value_type Lookup(char32_t code_point) noexcept {
-        auto it = std::ranges::lower_bound(data, code_point, {}, &Data::code_point);
-        if (it == data.end() || it->code_point != code_point) { return std::numeric_limits<char32_t>::max(); }
-        return it->value;
+        uint16_t index = hash.Find(code_point);
+        if (index == hash.NONE || data[index].code_point != code_point) { return std::numeric_limits<char32_t>::max(); }
+        return data[index].value;
     }
 
     static constexpr const UnicodeVersion &Version() noexcept { return version; }
@@ -468,6 +469,7 @@ private:
         Data{.code_point=0xff62, .value=0xff63},
         Data{.code_point=0xff63, .value=0xff62}
     }};
+    static constexpr PerfectHash<428> hash{data, &Data::code_point};
 };
 
 
@@ -0,0 +1,112 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+namespace jcu {
+
+
+/***
+ * Call func(worker, index) for every index in [0, count) on up to threads threads (the caller's thread is worker 0).
+ * Each worker starts with an even share of the indices and, once it runs out, steals the back half of the largest
+ * share left, so uneven work (e.g. a few large isolating run sequences among many small ones) is balanced without a
+ * central queue.  The first exception thrown by func is rethrown once every worker has stopped.
+ */
+template <typename Func_t>
+void ParallelFor(size_t count, size_t threads, Func_t&& func) {
+    threads = std::clamp<size_t>(threads, 1, count ? count : 1);
+    if (threads == 1) {
+        for (size_t index = 0; index < count; ++index) { std::invoke(func, size_t{0}, index); }
+        return;
+    }
+    if (count > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("ParallelFor supports at most 2^32 - 1 indices");
+    }
+
+    // The share of a worker is [begin, end) packed in one word so that the owner and a thief agree with a single CAS.
+    struct alignas(64) Share {
+        std::atomic<uint64_t> bounds{0};
+    };
+    auto Pack = [](uint64_t begin, uint64_t end) { return (end << 32) | begin; };
+    auto Begin = [](uint64_t bounds) { return bounds & 0xFFFFFFFF; };
+    auto End = [](uint64_t bounds) { return bounds >> 32; };
+
+    std::vector<Share> shares(threads);
+    for (size_t worker = 0; worker < threads; ++worker) {
+        shares[worker].bounds.store(Pack(count * worker / threads, count * (worker + 1) / threads),
+                                    std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error{};
+    std::mutex error_mutex{};
+
+    auto Work = [&](size_t worker) {
+        std::atomic<uint64_t>& own = shares[worker].bounds;
+        while (!failed.load(std::memory_order_relaxed)) {
+            uint64_t bounds = own.load(std::memory_order_acquire);
+            while (Begin(bounds) < End(bounds)) {
+                if (!own.compare_exchange_weak(bounds, Pack(Begin(bounds) + 1, End(bounds)),
+                                               std::memory_order_acq_rel)) { continue; }
+                try {
+                    std::invoke(func, worker, static_cast<size_t>(Begin(bounds)));
+                } catch (...) {
+                    std::scoped_lock lock{error_mutex};
+                    if (!error) { error = std::current_exception(); }
+                    failed.store(true, std::memory_order_relaxed);
+                    return;
+                }
+                bounds = own.load(std::memory_order_acquire);
+            }
+
+            // Steal the back half of the largest share; stop when every share is empty.
+            uint64_t stolen = 0;
+            while (!stolen) {
+                size_t victim = threads;
+                uint64_t most = 0;
+                for (size_t other = 0; other < threads; ++other) {
+                    uint64_t other_bounds = shares[other].bounds.load(std::memory_order_acquire);
+                    uint64_t size = End(other_bounds) - Begin(other_bounds);
+                    if (other != worker && size > most) { most = size; victim = other; }
+                }
+                if (victim == threads) { return; }
+
+                uint64_t victim_bounds = shares[victim].bounds.load(std::memory_order_acquire);
+                uint64_t begin = Begin(victim_bounds);
+                uint64_t end = End(victim_bounds);
+                if (begin >= end) { continue; }
+                uint64_t split = end - (end - begin + 1) / 2;
+                if (shares[victim].bounds.compare_exchange_strong(victim_bounds, Pack(begin, split),
+                                                                  std::memory_order_acq_rel)) {
+                    stolen = Pack(split, end);
+                }
+            }
+            own.store(stolen, std::memory_order_release);
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers{};
+        workers.reserve(threads - 1);
+        for (size_t worker = 1; worker < threads; ++worker) { workers.emplace_back(Work, worker); }
+        Work(0);
+    }
+
+    if (error) { std::rethrow_exception(error); }
+}
+
+
+}
@@ -0,0 +1,110 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+
+namespace jcu {
+
+
+/***
+ * Perfect hash over N distinct code points, built at compile time by hash and displace: the code points are spread
+ * over buckets by one hash and, largest bucket first, each bucket is given the seed of a second hash that places all of
+ * its code points in empty slots.  Find is two dependent loads with no probing; at most half of the slots are used.
+ */
+template <size_t N>
+class PerfectHash {
+public:
+    static constexpr uint16_t NONE = std::numeric_limits<uint16_t>::max();
+    static_assert(N < NONE, "PerfectHash indexes entries with 16 bits");
+
+private:
+    static constexpr size_t SLOTS = size_t{1} << (std::bit_width(N) + 1);
+    static constexpr size_t BUCKETS = SLOTS > 4 ? SLOTS / 4 : 1;
+    static constexpr uint32_t MAX_SEED = uint32_t{1} << 20;
+
+    std::array<uint32_t, BUCKETS> seeds{};
+    std::array<uint16_t, SLOTS> slots{};
+
+    static constexpr uint32_t Mix(uint32_t x) noexcept {
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static constexpr size_t Bucket(char32_t code_point) noexcept { return Mix(code_point) & (BUCKETS - 1); }
+
+    static constexpr size_t Slot(char32_t code_point, uint32_t seed) noexcept {
+        return Mix(static_cast<uint32_t>(code_point) ^ (seed * 0x9e3779b9)) & (SLOTS - 1);
+    }
+
+public:
+    /* Hash the key of each of the N entries; Find returns the index of the entry. */
+    template <typename Range_t, typename Proj=std::identity>
+    constexpr PerfectHash(const Range_t& entries, Proj proj={}) {
+        slots.fill(NONE);
+        auto Key = [&entries, &proj](size_t index) -> char32_t {
+            return std::invoke(proj, *(std::ranges::begin(entries) + index));
+        };
+
+        // Group the entries by bucket.
+        std::array<size_t, BUCKETS + 1> starts{};
+        for (size_t index = 0; index < N; ++index) { ++starts[Bucket(Key(index)) + 1]; }
+        std::partial_sum(starts.begin(), starts.end(), starts.begin());
+        std::array<uint16_t, N> members{};
+        std::array<size_t, BUCKETS> cursors{};
+        std::copy_n(starts.begin(), BUCKETS, cursors.begin());
+        for (size_t index = 0; index < N; ++index) {
+            members[cursors[Bucket(Key(index))]++] = static_cast<uint16_t>(index);
+        }
+
+        std::array<size_t, BUCKETS> order{};
+        std::iota(order.begin(), order.end(), size_t{0});
+        std::ranges::sort(order, [&starts](size_t a, size_t b) {
+            size_t size_a = starts[a + 1] - starts[a];
+            size_t size_b = starts[b + 1] - starts[b];
+            return size_a != size_b ? size_a > size_b : a < b;
+        });
+
+        for (size_t bucket : order) {
+            size_t first = starts[bucket];
+            size_t last = starts[bucket + 1];
+            if (first == last) { break; }
+
+            uint32_t seed = 1;
+            for (; seed < MAX_SEED; ++seed) {
+                size_t placed = first;
+                for (; placed < last; ++placed) {
+                    size_t slot = Slot(Key(members[placed]), seed);
+                    if (slots[slot] != NONE) { break; }
+                    slots[slot] = members[placed];
+                }
+                if (placed == last) { break; }
+                for (size_t undo = first; undo < placed; ++undo) { slots[Slot(Key(members[undo]), seed)] = NONE; }
+            }
+            if (seed == MAX_SEED) { throw std::logic_error("PerfectHash: no seed places every key of a bucket"); }
+            seeds[bucket] = seed;
+        }
+    }
+
+    /* Index of the entry whose key may be code_point or NONE; the caller compares the key. */
+    constexpr uint16_t Find(char32_t code_point) const noexcept {
+        return slots[Slot(code_point, seeds[Bucket(code_point)])];
+    }
+};
+
+
+}
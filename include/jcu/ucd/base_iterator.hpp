@@ -4,18 +4,22 @@
 
 
 #include <filesystem>
-#include <format>
-#include <fstream>
+#include <ios>
 #include <memory>
-#include <stdexcept>
-#include <string>
+#include <string_view>
 
+#include "jcu/allocation.hpp"
+#include "jcu/ucd/data_file.hpp"
 #include "jcu/ucd/utility.hpp"
 
 
 namespace jcu::ucd {
 
 
+/***
+ * Forward iterator over the entries of a data file.  Lines are views into a mapping of the file shared by every copy of
+ * the iterator, so a copy costs a reference count and an offset; mode is kept for the derived constructors and unused.
+ */
 template <typename Data_t, typename Derived_t>
 class FileIterator {
 public:
@@ -26,25 +30,26 @@ public:
     FileIterator() = default;
     FileIterator(bool /*sentinel*/) : is_done{true}, is_sentinel{true} {}
 protected:
-    FileIterator(const std::filesystem::path& path, std::ios_base::openmode mode)
-        : fs{OpenDataFile(path, mode)}, file_path{path}, mode{mode}
+    FileIterator(const std::filesystem::path& path, std::ios_base::openmode /*mode*/)
+        : cursor{MappedFile::Open(path)}, file_path{path}
         {}
 public:
-    FileIterator(const FileIterator& i) { *this = i; }
+    FileIterator(const FileIterator&) = default;
     FileIterator(FileIterator&&) noexcept = default;
     virtual ~FileIterator() = default;
-    FileIterator& operator=(const FileIterator& i) { Copy(i); return *this; }
+    FileIterator& operator=(const FileIterator&) = default;
     FileIterator& operator=(FileIterator&&) noexcept = default;
 
     friend bool operator==(const FileIterator<value_type, Derived_t>& lhs,
                            const FileIterator<value_type, Derived_t>& rhs) {
         if (lhs.is_sentinel && rhs.is_sentinel) { return true; }
-        int is_open = static_cast<int>(lhs.fs.is_open()) + static_cast<int>(rhs.fs.is_open());
+        int is_open = static_cast<int>(lhs.cursor.IsOpen()) + static_cast<int>(rhs.cursor.IsOpen());
         if (lhs.is_done != rhs.is_done || is_open == 1 || lhs.line_num != rhs.line_num) { return false; }
         return lhs.file_path == rhs.file_path;
     }
 
     auto& operator++() {
+        JCU_ALLOCATION_API("jcu::ucd::FileIterator::operator++");
         // Because the data is loaded in advance, the iterator is a "step" behind the file cursor.  If the data
         // consumed by ProcessLine goes all the way to the end of the file then is_done would be set true and the user
         // would think the range is complete without processing the last read data.  What we really want to know is
@@ -57,6 +62,7 @@ public:
     }
 
     auto operator++(this auto& self, int) {
+        JCU_ALLOCATION_API("jcu::ucd::FileIterator::operator++(int)");
         auto tmp = dynamic_cast<derived_type&>(self);
         ++self;
         return tmp;
@@ -67,11 +73,10 @@ public:
     size_t GetLineNum() const noexcept { return line_num; }
 
 protected:
-    std::string buffer{};
+    std::string_view buffer{};  //< Current line; a view into the mapping held by cursor.
     value_type data{};
-    std::ifstream fs{};
+    LineCursor cursor{};
     std::filesystem::path file_path{};
-    std::ios_base::openmode mode{std::ios::in};
     uint32_t line_num{0};
     bool is_done{false};
     bool is_sentinel{false};
@@ -80,37 +85,16 @@ protected:
     virtual value_type ProcessLine() = 0;
 
     void Init(this FileIterator& self) {
-        self.buffer.reserve(4096);
         ++self; // sets buffer to first entry or is marked as end FileIterator if no valid lines.
     }
 
-    void Copy(this auto&& self, const FileIterator& rhs) {
-        self.buffer = rhs.buffer;
-        self.data = rhs.data;
-        self.file_path = rhs.file_path;
-        self.mode = rhs.mode;
-        self.line_num = rhs.line_num;
-        self.is_done = rhs.is_done;
-        self.is_sentinel = rhs.is_sentinel;
-        if (self.fs.is_open()) { self.fs.close(); }
-        if (!self.file_path.empty() && rhs.fs.is_open()) {
-            self.fs = OpenDataFile(self.file_path, self.mode);
-            // tellg can set the failure bit; ok to throw exception
-            auto* ifs = const_cast<std::ifstream*>(std::addressof(rhs.fs));
-            self.fs.seekg(ifs->tellg(), std::ios::beg);
-        }
-    }
-
     void ReadLines(auto AcceptFunc) {
         if (is_done) { return; }
-        while (std::getline(fs, buffer)) {
+        while (cursor.Next(buffer)) {
             ++line_num;
-            if (AcceptFunc()) { break; }
-        }
-        if      (fs.rdstate() & std::ios_base::eofbit)  { is_done = true; }
-        else if (fs.rdstate() & std::ios_base::failbit) {
-            throw std::runtime_error{std::format("Unexpected line of data ({}): {}", line_num, buffer)};
+            if (AcceptFunc()) { return; }
         }
+        is_done = true;
     }
 };
 
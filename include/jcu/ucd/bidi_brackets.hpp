@@ -46,8 +46,8 @@ protected:
             if (sv == std::string_view{"o"}) { paired_type = BracketPairedType::OPEN; }
             else if (sv == std::string_view{"c"}) { paired_type = BracketPairedType::CLOSE; }
             return {
-                .code_point=static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16)),
-                .paired_code_point=static_cast<char32_t>(std::stoul(match2.to_string(), nullptr, 16)),
+                .code_point=ParseCodePoint(match1.to_view()),
+                .paired_code_point=ParseCodePoint(match2.to_view()),
                 .bracket_paired_type=paired_type
             };
         }
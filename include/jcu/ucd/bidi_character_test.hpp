@@ -22,9 +22,6 @@
 namespace jcu::ucd {
 
 
-constexpr uint8_t LEVEL_REMOVED = std::numeric_limits<uint8_t>::max();
-
-
 enum class ParagraphDirection : uint8_t {
     LTR=0,
     RTL=1,
@@ -63,30 +60,30 @@ protected:
         data.text = columns[0] |
                     std::views::split(' ') |
                     std::views::transform([](auto&& v) {
-                        return static_cast<char32_t>(std::stoul(std::string{std::string_view{v}}, nullptr, 16));
+                        return ParseCodePoint(std::string_view{v});
                     }) |
                     std::ranges::to<std::vector<char32_t>>();
 
-        auto dir = std::stoul(std::string{std::string_view{columns[1]}});
+        auto dir = ParseInteger<unsigned>(columns[1]);
         if      (dir == 0) { data.paragraph_direction = ParagraphDirection::LTR; }
         else if (dir == 1) { data.paragraph_direction = ParagraphDirection::RTL; }
         else if (dir == 2) { data.paragraph_direction = ParagraphDirection::AUTO; }
 
-        data.paragraph_level = static_cast<uint8_t>(std::stoul(std::string{std::string_view{columns[2]}}));
+        data.paragraph_level = ParseInteger<uint8_t>(columns[2]);
 
         data.levels = columns[3] |
                       std::views::split(' ') |
                       std::views::transform([](auto&& v) {
                           std::string_view sv{v};
                           if (sv[0] == 'x') { return LEVEL_REMOVED; }
-                          return static_cast<uint8_t>(std::stoul(std::string{sv}));
+                          return ParseInteger<uint8_t>(sv);
                       }) |
                       std::ranges::to<std::vector<uint8_t>>();
 
         data.order = columns[4] |
                      std::views::split(' ') |
                      std::views::transform([](auto&& v) {
-                         return static_cast<size_t>(std::stoull(std::string{std::string_view{v}}));
+                         return ParseInteger<size_t>(std::string_view{v});
                      }) |
                      std::ranges::to<std::vector<size_t>>();
 
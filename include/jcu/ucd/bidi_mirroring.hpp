@@ -43,8 +43,8 @@ protected:
     BidiMirroringUnit ProcessData() const {
         if (auto [whole, match1, match2] = REGEX(buffer); whole) {
             return {
-                .code_point=static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16)),
-                .mirror_code_point=static_cast<char32_t>(std::stoul(match2.to_string(), nullptr, 16))
+                .code_point=ParseCodePoint(match1.to_view()),
+                .mirror_code_point=ParseCodePoint(match2.to_view())
             };
         }
         throw std::runtime_error{std::format("Unexpected line of data ({}): {}", GetLineNum(), buffer)};
@@ -52,7 +52,7 @@ protected:
 
     BidiMirroringUnit ProcessUnmatched() const {
         if (auto [whole, match1] = REGEX_UNMATCHED(buffer); whole) {
-            return {.code_point=static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16))};
+            return {.code_point=ParseCodePoint(match1.to_view())};
         }
         throw std::runtime_error{std::format("Unexpected line of data ({}): {}", GetLineNum(), buffer)};
     }
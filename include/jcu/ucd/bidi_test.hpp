@@ -7,7 +7,6 @@
 #include <algorithm>
 #include <cstdint>
 #include <format>
-#include <fstream>
 #include <limits>
 #include <ranges>
 #include <stdexcept>
@@ -26,7 +25,6 @@
 namespace jcu::ucd {
 
 
-constexpr uint8_t LEVEL_REMOVED = std::numeric_limits<uint8_t>::max();
 constexpr uint8_t BIDI_PROPS_DIRECTION_BIT_INVALID = 0;
 constexpr uint8_t BIDI_PROPS_DIRECTION_BIT_AUTO_LTR = 1;
 constexpr uint8_t BIDI_PROPS_DIRECTION_BIT_LTR = 2;
@@ -63,7 +61,7 @@ protected:
             levels = REGEX_LEVEL_VALS(buffer) |
                      std::views::transform([](auto&& v) {
                          if (v.to_view()[0] == 'x') { return LEVEL_REMOVED; }
-                         return static_cast<uint8_t>(std::stoul(v.to_string()));
+                         return ParseInteger<uint8_t>(v.to_view());
                      }) |
                      std::ranges::to<std::vector<uint8_t>>();
 
@@ -74,7 +72,7 @@ protected:
                 throw std::runtime_error{std::format("Unexpected line of data ({}): {}", GetLineNum(), buffer)};
             }
             reorders = REGEX_REORDER_VALS(buffer) |
-                       std::views::transform([](auto&& v) { return static_cast<uint8_t>(std::stoul(v.to_string())); }) |
+                       std::views::transform([](auto&& v) { return ParseInteger<size_t>(v.to_view()); }) |
                        std::ranges::to<std::vector<size_t>>();
 
             this->ReadLines([this]() { return this->AcceptLine(); });
@@ -87,7 +85,7 @@ protected:
 
         auto it = std::ranges::find(buffer, ';');
         std::string_view col1{buffer.begin(), it};
-        std::string col2{it + 1, buffer.end()};
+        std::string_view col2{it + 1, buffer.end()};
         auto value_strings = REGEX_DATA_VALS(col1) |
                              std::views::transform([](auto&& v) { return v.to_string(); }) |
                              std::ranges::to<std::vector<std::string>>();
@@ -106,7 +104,7 @@ protected:
             .levels=levels,
             .reorders=reorders,
             .values=std::move(values),
-            .direction_bitset=static_cast<uint8_t>(std::stoul(col2)),
+            .direction_bitset=ParseInteger<uint8_t>(col2),
             .line_num=GetLineNum()
         };
     }
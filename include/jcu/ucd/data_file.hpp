@@ -0,0 +1,171 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace jcu::ucd {
+
+
+/***
+ * Read only memory mapping of a whole data file.  The data files are parsed front to back once, so mapping them lets
+ * the kernel read ahead and hands the parsers lines as views into the page cache with no copy.  An empty file has no
+ * mapping and an empty view.
+ */
+class MappedFile {
+    const char* data{nullptr};
+    size_t size{0};
+
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+        if (!std::filesystem::exists(path)) {
+            throw std::runtime_error{std::format("File not found: {}\n{}",
+                                     path.generic_string(), std::filesystem::absolute(path).generic_string())};
+        }
+        auto OnError = [&path]() {
+            return std::runtime_error{std::format("File failed to map: {}\n{}",
+                                      path.generic_string(), std::filesystem::absolute(path).generic_string())};
+        };
+
+#if defined(_WIN32)
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) { throw OnError(); }
+        LARGE_INTEGER file_size{};
+        if (!GetFileSizeEx(file, &file_size)) { CloseHandle(file); throw OnError(); }
+        size = static_cast<size_t>(file_size.QuadPart);
+        if (size) {
+            // The view keeps the mapping alive; neither handle is needed once it exists.
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+        if (size && !data) { throw OnError(); }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { throw OnError(); }
+        struct stat status{};
+        if (::fstat(fd, &status) != 0) { ::close(fd); throw OnError(); }
+        size = static_cast<size_t>(status.st_size);
+        if (size) {
+            void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                data = static_cast<const char*>(address);
+#if defined(MADV_SEQUENTIAL)
+                ::madvise(address, size, MADV_SEQUENTIAL);
+#endif
+            }
+        }
+        ::close(fd);
+        if (size && !data) { throw OnError(); }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (!data) { return; }
+#if defined(_WIN32)
+        UnmapViewOfFile(data);
+#else
+        ::munmap(const_cast<char*>(data), size);
+#endif
+    }
+
+    std::string_view View() const noexcept { return {data, size}; }
+
+    /* Mapping shared by every cursor (and copy of a cursor) over path. */
+    static std::shared_ptr<const MappedFile> Open(const std::filesystem::path& path) {
+        return std::make_shared<const MappedFile>(path);
+    }
+};
+
+
+/***
+ * Forward cursor over the lines of a mapped file.  A copy shares the mapping and only duplicates the offset, so copying
+ * a file iterator no longer reopens and seeks the file.  Lines are split at '\n' which is not part of the line; a last
+ * line without a '\n' is still a line.
+ */
+class LineCursor {
+    std::shared_ptr<const MappedFile> file{};
+    size_t offset{0};
+
+public:
+    LineCursor() = default;
+    explicit LineCursor(std::shared_ptr<const MappedFile> file) : file{std::move(file)} {}
+
+    bool IsOpen() const noexcept { return file != nullptr; }
+    size_t Offset() const noexcept { return offset; }
+
+    /* Set line to the next line and return true, or return false at the end of the file. */
+    bool Next(std::string_view& line) noexcept {
+        if (!file) { return false; }
+        std::string_view text = file->View();
+        if (offset >= text.size()) { return false; }
+
+        size_t end = std::min(text.find('\n', offset), text.size());
+        line = text.substr(offset, end - offset);
+        offset = end + 1;
+        return true;
+    }
+};
+
+
+/***
+ * Integer in field written in base, ignoring surrounding blanks.  Unlike std::stoul no string is built, and a field
+ * that is not entirely a number or does not fit in T throws std::runtime_error instead of being cut short or truncated.
+ */
+template <std::integral T>
+T ParseInteger(std::string_view field, int base=10) {
+    auto IsBlank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+    while (!field.empty() && IsBlank(field.front())) { field.remove_prefix(1); }
+    while (!field.empty() && IsBlank(field.back())) { field.remove_suffix(1); }
+
+    T value{};
+    auto [end, error] = std::from_chars(field.data(), field.data() + field.size(), value, base);
+    if (error != std::errc{} || end != field.data() + field.size()) {
+        throw std::runtime_error{std::format("Invalid base {} integer: '{}'", base, field)};
+    }
+    return value;
+}
+
+
+/* Code point written in hex as in every UCD file. */
+inline char32_t ParseCodePoint(std::string_view field) {
+    return static_cast<char32_t>(ParseInteger<uint32_t>(field, 16));
+}
+
+
+}
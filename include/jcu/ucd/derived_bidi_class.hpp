@@ -14,10 +14,10 @@
 
 #include <ctre.hpp>
 
-#include "jcu/constants.hpp"
 #include "jcu/bidi/bidi_type.hpp"
 #include "jcu/strings/bidi_type.hpp"
 #include "jcu/ucd/base_iterator.hpp"
+#include "jcu/ucd/range_map.hpp"
 #include "jcu/unicode_version.hpp"
 
 
@@ -69,8 +69,8 @@ protected:
 
     DerivedBidiClassUnit ProcessUnit(std::string_view sv) const {
         if (auto [whole, match1, match2, match3] = REGEX(sv); whole) {
-            char32_t first = static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16));
-            char32_t last = !match2 ? first : static_cast<char32_t>(std::stoul(match2.to_string(), nullptr, 16));
+            char32_t first = ParseCodePoint(match1.to_view());
+            char32_t last = !match2 ? first : ParseCodePoint(match2.to_view());
             return {
                 .code_point_first=first,
                 .code_point_last=last,
@@ -110,34 +110,17 @@ public:
     DerivedBidiClass(const std::filesystem::path& directory)
     : version{ExtractVersion(directory / FILE_NAME, OPEN_MODE)}
     {
-        // Create a vector of BidiType for all possible code points.  Throw exception (.at) for unexpected code points.
-        // Assumptions:
-        //     1. Missing ranges come before assigned value ranges
-        //     2. The global default L is the first range of missing followed by non-overlapping ranges in missing.
-        //     3. The ranges of assigned values are non-overlapping for all ranges of assigned values, not missing.
-        // TODO: Add validation steps.
+        // Ranges are applied in file order so the data lines override the @missing defaults that precede them.
         DerivedBidiClassFileIterator it{directory / FILE_NAME, OPEN_MODE};
         DerivedBidiClassFileIterator end{true};
 
-        std::vector all_bidi_types(jcu::CODE_POINT_MAX + 1, jcu::bidi::BidiType::NIL);
-        std::ranges::for_each(it, end, [&all_bidi_types](auto&& unit) mutable {
+        RangeMap<jcu::bidi::BidiType> bidi_types{jcu::bidi::BidiType::NIL};
+        std::ranges::for_each(it, end, [&bidi_types](auto&& unit) {
             auto result = MISSING_REGEX(unit.bidi_type);
             auto bidi_type = jcu::strings::bidi_type::FromString(result.get<1>().to_view());
-            size_t start = static_cast<size_t>(unit.code_point_first);
-            size_t last  = static_cast<size_t>(unit.code_point_last);
-            for (auto i : std::views::iota(start, last + 1)) { all_bidi_types.at(i) = bidi_type; }
+            bidi_types.Assign(unit.code_point_first, unit.code_point_last, bidi_type);
         });
-
-        // Condense bidi type runs
-        data.reserve(1 + std::ranges::count_if(all_bidi_types | std::views::pairwise, [](auto&& pair) {
-            auto [a, b] = pair; return a != b;
-        }));
-        data.push_back({.code_point=0, .value=all_bidi_types[0]});
-        for (auto [index, pair] : std::views::enumerate(all_bidi_types | std::views::pairwise)) {
-            auto [a, b] = pair;
-            if (a != b) { data.push_back({.code_point=static_cast<char32_t>(index + 1), .value=b}); }
-        }
-        data.push_back({.code_point=(jcu::CODE_POINT_MAX + 1), .value=jcu::bidi::BidiType::NIL});
+        data = bidi_types.ToTable<Data>(jcu::bidi::BidiType::NIL);
     }
 
     auto begin() const { return data.cbegin(); }
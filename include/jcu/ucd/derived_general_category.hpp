@@ -15,10 +15,10 @@
 
 #include <ctre.hpp>
 
-#include "jcu/constants.hpp"
 #include "jcu/general_category.hpp"
 #include "jcu/strings/general_category.hpp"
 #include "jcu/ucd/base_iterator.hpp"
+#include "jcu/ucd/range_map.hpp"
 #include "jcu/unicode_version.hpp"
 
 
@@ -42,8 +42,8 @@ protected:
 
     DerivedGeneralCategoryUnit ProcessLine() override {
         if (auto [whole, match1, match2, match3] = REGEX(buffer); whole) {
-            char32_t first = static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16));
-            char32_t last = !match2 ? first : static_cast<char32_t>(std::stoul(match2.to_string(), nullptr, 16));
+            char32_t first = ParseCodePoint(match1.to_view());
+            char32_t last = !match2 ? first : ParseCodePoint(match2.to_view());
             return {
                 .code_point_first=first,
                 .code_point_last=last,
@@ -81,32 +81,16 @@ public:
     DerivedGeneralCategory(const std::filesystem::path& directory)
     : version{ExtractVersion(directory / FILE_NAME, OPEN_MODE)}
     {
-        // Create a vector of GeneralCategory for all possible code points.  Throw exception (.at) for unexpected
-        // code points.
-        // Assumptions:
-        //     1. No gaps; i.e. default value is NIL
-        // TODO: Add validation steps.
+        // The file lists every assigned range; code points it does not list stay NIL.
         DerivedGeneralCategoryFileIterator it{directory / FILE_NAME, OPEN_MODE};
         DerivedGeneralCategoryFileIterator end{true};
 
-        std::vector<GeneralCategory> all_general_categories(jcu::CODE_POINT_MAX + 1, GeneralCategory::NIL);
-        std::ranges::for_each(it, end, [&all_general_categories](auto&& unit) mutable {
+        RangeMap<GeneralCategory> general_categories{GeneralCategory::NIL};
+        std::ranges::for_each(it, end, [&general_categories](auto&& unit) {
             GeneralCategory general_category = jcu::strings::general_category::FromString(unit.general_category);
-            size_t start = static_cast<size_t>(unit.code_point_first);
-            size_t last  = static_cast<size_t>(unit.code_point_last);
-            for (auto i : std::views::iota(start, last + 1)) { all_general_categories.at(i) = general_category; }
+            general_categories.Assign(unit.code_point_first, unit.code_point_last, general_category);
         });
-
-        // Condense bidi type runs
-        data.reserve(1 + std::ranges::count_if(all_general_categories | std::views::pairwise, [](auto&& pair) {
-            auto [a, b] = pair; return a != b;
-        }));
-        data.push_back({.code_point=0, .value=all_general_categories[0]});
-        for (auto [index, pair] : std::views::enumerate(all_general_categories | std::views::pairwise)) {
-            auto [a, b] = pair;
-            if (a != b) { data.push_back({.code_point=static_cast<char32_t>(index + 1), .value=b}); }
-        }
-        data.push_back({.code_point=(jcu::CODE_POINT_MAX + 1), .value=GeneralCategory::NIL});
+        data = general_categories.ToTable<Data>(GeneralCategory::NIL);
     }
 
     auto begin() const { return data.cbegin(); }
@@ -0,0 +1,70 @@
+// Copyright © 2024 Jason Stredwick
+
+#pragma once
+
+
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "jcu/constants.hpp"
+
+
+namespace jcu::ucd {
+
+
+/***
+ * Property value of every code point kept as sorted, non-overlapping ranges.  Each key starts a range that runs up to
+ * the next key; the key CODE_POINT_MAX + 1 always exists and ends the last range.  Assign overrides whatever the range
+ * held before, which is how the data files layer their ranges over the @missing defaults that come first.  Work is
+ * proportional to the number of ranges in the file rather than to the number of code points.
+ */
+template <typename Value_t>
+class RangeMap {
+    std::map<char32_t, Value_t> starts{};
+
+public:
+    explicit RangeMap(Value_t initial={}) : starts{{0, initial}, {jcu::CODE_POINT_MAX + 1, initial}} {}
+
+    /* Set [first, last] to value; throws std::out_of_range for an empty range or one beyond CODE_POINT_MAX. */
+    void Assign(char32_t first, char32_t last, Value_t value) {
+        if (first > last || last > jcu::CODE_POINT_MAX) {
+            throw std::out_of_range{std::format("Invalid code point range: {:04X}..{:04X}",
+                                                static_cast<uint32_t>(first), static_cast<uint32_t>(last))};
+        }
+
+        // Keep the value that resumes after last, then drop every start inside [first, last + 1].
+        char32_t end = last + 1;
+        auto end_it = starts.upper_bound(end);
+        Value_t resume = std::prev(end_it)->second;
+        starts.erase(starts.lower_bound(first), end_it);
+        starts.emplace_hint(end_it, end, resume);
+        starts.emplace(first, value);
+    }
+
+    Value_t operator[](char32_t code_point) const { return std::prev(starts.upper_bound(code_point))->second; }
+
+    /***
+     * Condensed table of Data_t{.code_point, .value}: one entry per change of value starting with code point 0, then
+     * the sentinel {CODE_POINT_MAX + 1, sentinel}.  Adjacent ranges of the same value are merged.
+     */
+    template <typename Data_t>
+    std::vector<Data_t> ToTable(Value_t sentinel={}) const {
+        std::vector<Data_t> table{};
+        table.reserve(starts.size());
+        for (const auto& [code_point, value] : starts) {
+            if (code_point > jcu::CODE_POINT_MAX) { break; }
+            if (table.empty() || table.back().value != value) {
+                table.push_back({.code_point=code_point, .value=value});
+            }
+        }
+        table.push_back({.code_point=(jcu::CODE_POINT_MAX + 1), .value=sentinel});
+        return table;
+    }
+};
+
+
+}
@@ -14,10 +14,10 @@
 #include <ctre.hpp>
 
 #include "jcu/ucd/base_iterator.hpp"
+#include "jcu/ucd/range_map.hpp"
 #include "jcu/unicode_version.hpp"
 #include "jcu/script.hpp"
 #include "jcu/strings/script.hpp"
-#include "jcu/constants.hpp"
 
 
 namespace jcu::ucd {
@@ -58,8 +58,8 @@ protected:
 
     ScriptsUnit ProcessUnit(std::string_view sv) const {
         if (auto [whole, match1, match2, match3] = REGEX(sv); whole) {
-            char32_t first = static_cast<char32_t>(std::stoul(match1.to_string(), nullptr, 16));
-            char32_t last = !match2 ? first : static_cast<char32_t>(std::stoul(match2.to_string(), nullptr, 16));
+            char32_t first = ParseCodePoint(match1.to_view());
+            char32_t last = !match2 ? first : ParseCodePoint(match2.to_view());
             return {
                 .code_point_first=first,
                 .code_point_last=last,
@@ -100,36 +100,19 @@ public:
     Scripts(const std::filesystem::path& directory)
     : version{ExtractVersion(directory / FILE_NAME, OPEN_MODE)}
     {
-        // Create a vector of Script for all possible code points.  Throw exception (.at) for unexpected code points.
-        // Assumptions:
-        //     1. Missing ranges come before assigned value ranges
-        //     2. The global default L is the first range of missing followed by non-overlapping ranges in missing.
-        //     3. The ranges of assigned values are non-overlapping for all ranges of assigned values, not missing.
-        // TODO: Add validation steps.
+        // Ranges are applied in file order so the data lines override the @missing defaults that precede them.
         ScriptsFileIterator it{directory / FILE_NAME, OPEN_MODE};
         ScriptsFileIterator end{true};
 
-        std::vector<Script> all_scripts(jcu::CODE_POINT_MAX + 1, Script::NIL);
-        std::ranges::for_each(it, end, [&all_scripts, &script_names=this->script_names](auto&& unit) mutable {
+        RangeMap<Script> scripts{Script::NIL};
+        std::ranges::for_each(it, end, [&scripts, &script_names=this->script_names](auto&& unit) {
             auto result = MISSING_REGEX(unit.script_name);
             std::string_view script_name_sv = result.get<1>().to_view();
             Script script = jcu::strings::script::FromString(script_name_sv);
-            size_t start = static_cast<size_t>(unit.code_point_first);
-            size_t last  = static_cast<size_t>(unit.code_point_last);
-            for (auto i : std::views::iota(start, last + 1)) { all_scripts.at(i) = script; }
+            scripts.Assign(unit.code_point_first, unit.code_point_last, script);
             script_names.insert(std::string{script_name_sv});
         });
-
-        // Condense script type runs
-        data.reserve(1 + std::ranges::count_if(all_scripts | std::views::pairwise, [](auto&& pair) {
-            auto [a, b] = pair; return a != b;
-        }));
-        data.push_back({.code_point=0, .value=all_scripts[0]});
-        for (auto [index, pair] : std::views::enumerate(all_scripts | std::views::pairwise)) {
-            auto [a, b] = pair;
-            if (a != b) { data.push_back({.code_point=static_cast<char32_t>(index + 1), .value=b}); }
-        }
-        data.push_back({.code_point=(jcu::CODE_POINT_MAX + 1), .value=Script::NIL});
+        data = scripts.ToTable<Data>(Script::NIL);
     }
 
     auto begin() const { return data.cbegin(); }
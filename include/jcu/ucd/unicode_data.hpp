@@ -5,7 +5,6 @@
 
 #include <algorithm>
 #include <filesystem>
-#include <fstream>
 #include <ranges>
 #include <stdexcept>
 #include <string>
@@ -50,8 +49,10 @@ protected:
 
         auto it = split_view.begin();
         auto Extract = [](auto&& i) { std::string out{std::string_view{*i}}; ++i; return out; };
+        char32_t code_point = ParseCodePoint(std::string_view{*it});
+        ++it;
         return {
-            .code_point=static_cast<char32_t>(std::stoul(Extract(it), nullptr, 16)),
+            .code_point=code_point,
             .character_name=Extract(it),
             .general_category=Extract(it),
             .combining_class=Extract(it),
@@ -87,10 +88,7 @@ public:
     static constexpr std::ios_base::openmode OPEN_MODE = std::ios::in | std::ios::binary;
 
     UnicodeData(const std::filesystem::path& directory) {
-        {
-            std::ifstream fs{directory / FILE_NAME, OPEN_MODE};
-            data.reserve(DataFileNumLines(fs));
-        }
+        data.reserve(DataFileNumLines(MappedFile::Open(directory / FILE_NAME)->View()));
         UnicodeDataIterator it{directory / FILE_NAME, OPEN_MODE};
         UnicodeDataIterator end{true};
         std::ranges::transform(it, end, std::back_inserter(data), std::identity{});
@@ -4,21 +4,28 @@
 
 
 #include <algorithm>
+#include <cstdint>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
 #include <ctre.hpp>
 
+#include "jcu/ucd/data_file.hpp"
 #include "jcu/unicode_version.hpp"
 
 
 namespace jcu::ucd {
 
 
+/* Level of a character removed by rule X9 in BidiTest.txt and BidiCharacterTest.txt ('x'). */
+constexpr uint8_t LEVEL_REMOVED = std::numeric_limits<uint8_t>::max();
+
+
 static constexpr auto REGEX_UNICODE_VERSION = ctre::match<"^[^\\-]+[\\-]([0-9]+)[.]([0-9]+)[.]([0-9]+)[.].+">;
 
 
@@ -40,6 +47,9 @@ size_t DataFileNumLines(std::ifstream& fs) {
 }
 
 
+inline size_t DataFileNumLines(std::string_view text) { return 1 + std::ranges::count(text, '\n'); }
+
+
 std::ifstream OpenDataFile(const std::filesystem::path& path,
                            std::ios_base::openmode mode=(std::ios::in | std::ios::binary)) {
     if (!std::filesystem::exists(path)) {
@@ -57,19 +67,19 @@ std::ifstream OpenDataFile(const std::filesystem::path& path,
 }
 
 
-jcu::UnicodeVersion ExtractVersion(const std::filesystem::path& path, std::ios_base::openmode mode) {
-    std::ifstream fs = OpenDataFile(path, mode);
-    std::string version_line{};
-    version_line.reserve(4096);
-    std::getline(fs, version_line);
-    if (fs.rdstate() != std::ios_base::goodbit) {
+/* Version from the header of a data file; the first line is read from the mapping, mode is no longer used. */
+jcu::UnicodeVersion ExtractVersion(const std::filesystem::path& path,
+                                   std::ios_base::openmode /*mode*/=(std::ios::in | std::ios::binary)) {
+    LineCursor cursor{MappedFile::Open(path)};
+    std::string_view version_line{};
+    if (!cursor.Next(version_line)) {
         throw std::runtime_error{std::format("Failed open file: {}", path.generic_string())};
     }
     if (auto [whole, major, minor, micro] = REGEX_UNICODE_VERSION(version_line); whole) {
         return {
-            .major=static_cast<uint8_t>(std::stoul(major.to_string())),
-            .minor=static_cast<uint8_t>(std::stoul(minor.to_string())),
-            .micro=static_cast<uint8_t>(std::stoul(micro.to_string()))
+            .major=ParseInteger<uint8_t>(major.to_view()),
+            .minor=ParseInteger<uint8_t>(minor.to_view()),
+            .micro=ParseInteger<uint8_t>(micro.to_view())
         };
     }
     throw std::runtime_error{std::format("Failed to parse version: {}", version_line)};
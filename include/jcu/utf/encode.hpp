@@ -5,6 +5,7 @@
 
 #include <string>
 
+#include "jcu/allocation.hpp"
 #include "jcu/utf/core.hpp"
 
 
@@ -13,6 +14,7 @@ namespace jcu::utf {
 
 // Assumes code_point has been validated; otherwise will attempt to convert as-is.
 constexpr std::u8string EncodeUTF8(char32_t code_point) {
+    JCU_ALLOCATION_API("jcu::utf::EncodeUTF8");
     if (code_point < 0x80) {                     // 1 byte
         return std::u8string{static_cast<char8_t>(code_point)};
     } else if (code_point < 0x800) {             // 2 bytes
@@ -38,6 +40,7 @@ constexpr std::u8string EncodeUTF8(char32_t code_point) {
 
 // Assumes code_point has been validated; otherwise will attempt to convert as-is.
 constexpr std::u16string EncodeUTF16(char32_t code_point) {
+    JCU_ALLOCATION_API("jcu::utf::EncodeUTF16");
     if (IsInBMP(code_point)) { return std::u16string{static_cast<char16_t>(code_point)}; }
     // Code points from the supplementary planes are encoded via surrogate pairs
     return std::u16string{
@@ -48,6 +51,7 @@ constexpr std::u16string EncodeUTF16(char32_t code_point) {
 
 
 constexpr std::u32string EncodeUTF32(char32_t code_point) {
+    JCU_ALLOCATION_API("jcu::utf::EncodeUTF32");
     return std::u32string{code_point};
 }
 
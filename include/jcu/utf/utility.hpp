@@ -5,8 +5,11 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <memory>
 #include <string>
 
+#include "jcu/allocation.hpp"
+#include "jcu/allocator.hpp"
 #include "jcu/utf/concepts.hpp"
 #include "jcu/utf/core.hpp"
 #include "jcu/utf/iterators.hpp"
@@ -25,8 +28,10 @@ struct AttemptedConvertResult {
 
 
 // TODO: Should I enforce std::ranges::borrowed_range to prevent dangling iterators on temporary ranges?
-template <IsUTF_c Dst_t>
-constexpr auto AttemptConvertToUTF(IsCompatibleRange_c auto&& rng, std::basic_string<Dst_t>& dst) {
+template <IsUTF_c Dst_t, typename Traits_t, typename Allocator_t>
+constexpr auto AttemptConvertToUTF(IsCompatibleRange_c auto&& rng,
+                                   std::basic_string<Dst_t, Traits_t, Allocator_t>& dst) {
+    JCU_ALLOCATION_API("jcu::utf::AttemptConvertToUTF");
     DecodeDataView view{rng};
     auto out_it = CodePointAppender(dst);
     for (auto it=view.begin(); it!=view.end(); ++it) {
@@ -47,12 +52,16 @@ constexpr auto AttemptConvertToUTF(IsCompatibleRange_c auto&& rng, std::basic_st
 }
 
 
-// Assumes input is not validated; will replace invalid code points with REPLACEMENT_CHARACTER.
-template <IsCompatibleRange_c Range_t, IsUTF_c Dst_t>
-constexpr std::basic_string<Dst_t> ConvertToUTF(const Range_t& rng,
-                                                char32_t replacement_character=REPLACEMENT_CHARACTER,
-                                                bool reserve=false) {
-    std::basic_string<Dst_t> result{};
+// Assumes input is not validated; will replace invalid code points with REPLACEMENT_CHARACTER.  The result is
+// allocated by allocator rebound to Dst_t (see jcu/allocator.hpp).
+template <IsCompatibleRange_c Range_t, IsUTF_c Dst_t, jcu::Allocator_c Allocator_t>
+constexpr auto ConvertToUTF(const Range_t& rng,
+                            const Allocator_t& allocator,
+                            char32_t replacement_character=REPLACEMENT_CHARACTER,
+                            bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF");
+    using Result_t = std::basic_string<Dst_t, std::char_traits<Dst_t>, jcu::RebindAllocator_t<Allocator_t, Dst_t>>;
+    Result_t result(typename Result_t::allocator_type{allocator});
     auto view = CodePointView{rng};
     if (reserve) { result.reserve(std::ranges::distance(view)); }
     std::ranges::copy(view | ReplaceInvalid(replacement_character), CodePointAppender(result));
@@ -60,29 +69,70 @@ constexpr std::basic_string<Dst_t> ConvertToUTF(const Range_t& rng,
 }
 
 
+// Same as above with the result allocated by std::allocator.
+template <IsCompatibleRange_c Range_t, IsUTF_c Dst_t>
+constexpr std::basic_string<Dst_t> ConvertToUTF(const Range_t& rng,
+                                                char32_t replacement_character=REPLACEMENT_CHARACTER,
+                                                bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF");
+    return ConvertToUTF<Range_t, Dst_t>(rng, std::allocator<Dst_t>{}, replacement_character, reserve);
+}
+
+
 constexpr auto ConvertToUTF8(IsCompatibleRange_c auto && rng,
                              char32_t replacement_character=REPLACEMENT_CHARACTER,
                              bool reserve=false)  {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF8");
     return ConvertToUTF<decltype(rng), char8_t>(rng, replacement_character, reserve);
 }
 
 
+constexpr auto ConvertToUTF8(IsCompatibleRange_c auto && rng,
+                             const jcu::Allocator_c auto& allocator,
+                             char32_t replacement_character=REPLACEMENT_CHARACTER,
+                             bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF8");
+    return ConvertToUTF<decltype(rng), char8_t>(rng, allocator, replacement_character, reserve);
+}
+
+
 constexpr auto ConvertToUTF16(IsCompatibleRange_c auto && rng,
                               char32_t replacement_character=REPLACEMENT_CHARACTER,
                               bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF16");
     return ConvertToUTF<decltype(rng), char16_t>(rng, replacement_character, reserve);
 }
 
 
+constexpr auto ConvertToUTF16(IsCompatibleRange_c auto && rng,
+                              const jcu::Allocator_c auto& allocator,
+                              char32_t replacement_character=REPLACEMENT_CHARACTER,
+                              bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF16");
+    return ConvertToUTF<decltype(rng), char16_t>(rng, allocator, replacement_character, reserve);
+}
+
+
 constexpr auto ConvertToUTF32(IsCompatibleRange_c auto && rng,
                               char32_t replacement_character=REPLACEMENT_CHARACTER,
                               bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF32");
     return ConvertToUTF<decltype(rng), char32_t>(rng, replacement_character, reserve);
 }
 
 
+constexpr auto ConvertToUTF32(IsCompatibleRange_c auto && rng,
+                              const jcu::Allocator_c auto& allocator,
+                              char32_t replacement_character=REPLACEMENT_CHARACTER,
+                              bool reserve=false) {
+    JCU_ALLOCATION_API("jcu::utf::ConvertToUTF32");
+    return ConvertToUTF<decltype(rng), char32_t>(rng, allocator, replacement_character, reserve);
+}
+
+
 // TODO: Should I enforce std::ranges::borrowed_range to prevent dangling iterators on temporary ranges?
 constexpr auto FindFirstInvalid(IsCompatibleRange_c auto && rng) {
+    JCU_ALLOCATION_API("jcu::utf::FindFirstInvalid");
     auto IsOK_f = [](auto v) { return v == DecodeError::OK; };
     DecodeDataView view{rng};
     using Data = std::ranges::range_value_t<decltype(view)>;
@@ -92,6 +142,7 @@ constexpr auto FindFirstInvalid(IsCompatibleRange_c auto && rng) {
 
 
 constexpr bool IsValid(IsCompatibleRange_c auto && rng) {
+    JCU_ALLOCATION_API("jcu::utf::IsValid");
     auto IsOK_f = [](auto v) { return v == DecodeError::OK; };
     using Data = std::ranges::range_value_t<decltype(DecodeDataView{rng})>;
     return std::ranges::all_of(DecodeDataView{rng}, IsOK_f, &Data::error_code);
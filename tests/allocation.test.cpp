@@ -0,0 +1,152 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/allocation.hpp"
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/direction.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/classify.hpp"
+#include "jcu/data/derived_bidi_class.hpp"
+#include "jcu/utf/utf.hpp"
+#include "ftest.h"
+
+
+JCU_INSTALL_ALLOCATION_TRACKING();
+
+
+namespace {
+
+
+const jcu::ApiAllocations* Find(const std::vector<jcu::ApiAllocations>& report, std::string_view api) {
+    auto it = std::ranges::find(report, api, &jcu::ApiAllocations::api);
+    return it == report.end() ? nullptr : &*it;
+}
+
+
+}
+
+
+TEST(AllocationTests, test_Scope) {
+    jcu::AllocationScope scope{};
+    EXPECT_TRUE(scope.Counts() == jcu::AllocationCounts{});
+
+    std::vector<uint32_t> values(100);
+    EXPECT_EQ(scope.Counts().count, 1);
+    EXPECT_EQ(scope.Counts().bytes, 400);
+    values.clear();
+    values.shrink_to_fit();
+    EXPECT_EQ(scope.Counts().count, 1);   // Frees are not counted.
+}
+
+
+TEST(AllocationTests, test_NoAllocationPaths) {
+    using namespace jcu;
+
+    std::u8string text{u8"abc אבג (١٢) \U0001F600 def"};
+    std::u16string text16{u"abc אבג (١٢) \U0001F600 def"};
+    std::array<char32_t, 64> code_points{};
+    std::array<bidi::BidiType, 64> bidi_types{};
+    bidi::BidiWorkspace<> workspace{};
+    std::vector<bidi::Run> runs{};
+    bidi::AppendRuns(workspace, text, bidi::LEVEL_TYPE_DEFAULT_AUTO, runs);  // Grows the workspace and runs.
+
+    AllocationScope scope{};
+    uint64_t sum = 0;
+    for (char32_t code_point : utf::CodePointView{text}) { sum += code_point; }
+    for (const auto& data : utf::DecodeDataView{text16}) { sum += data.code_point; }
+    EXPECT_TRUE(utf::IsValid(text));
+    EXPECT_TRUE(utf::FindFirstInvalid(text16) == text16.end());
+    sum += utf::EncodeUTF8(U'\U0001F600').size() + utf::EncodeUTF16(U'\U0001F600').size();
+    sum += static_cast<uint64_t>(data::DerivedBidiClass::Lookup(U'א'));
+    sum += Classify(text, {.code_points=code_points, .bidi_types=bidi_types});
+    EXPECT_TRUE(bidi::DetectBaseDirection(text) == bidi::BaseDirection::LTR);
+    for (size_t repeat = 0; repeat < 3; ++repeat) {
+        runs.clear();
+        bidi::AppendRuns(workspace, text, bidi::LEVEL_TYPE_DEFAULT_AUTO, runs);
+    }
+    EXPECT_EQ(scope.Counts().count, 0);
+    EXPECT_TRUE(sum > 0);
+}
+
+
+TEST(AllocationTests, test_AllocatingPaths) {
+    using namespace jcu;
+
+    std::u8string text(1000, u8'a');
+    {
+        AllocationScope scope{};
+        std::vector<bidi::Run> runs = bidi::ToRuns(text);
+        EXPECT_TRUE(scope.Counts().count > 0);
+        EXPECT_TRUE(scope.Counts().bytes >= text.size() * sizeof(bidi::BidiType));
+    }
+    {
+        AllocationScope scope{};
+        std::u32string converted = utf::ConvertToUTF32(text);
+        EXPECT_TRUE(scope.Counts().count > 0);
+        EXPECT_TRUE(scope.Counts().bytes >= text.size() * sizeof(char32_t));
+    }
+}
+
+
+TEST(AllocationTests, test_ArenaPaths) {
+    using namespace jcu;
+
+    std::u8string text{u8"abc אבג (١٢) \U0001F600 def"};
+    std::vector<std::byte> buffer(1 << 16);
+
+    AllocationScope scope{};
+    {
+        std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+        std::pmr::polymorphic_allocator<> allocator{&arena};
+        std::pmr::vector<bidi::Run> runs = bidi::ToRuns(text, allocator);
+        std::pmr::u16string converted = utf::ConvertToUTF16(text, allocator);
+        EXPECT_FALSE(runs.empty());
+        EXPECT_FALSE(converted.empty());
+    }
+    EXPECT_EQ(scope.Counts().count, 0);
+}
+
+TEST(AllocationTests, test_Report) {
+    using namespace jcu;
+
+    std::u8string text{u8"abc אבג"};
+    bidi::BidiWorkspace<> workspace{};
+    std::vector<bidi::Run> runs{};
+    bidi::AppendRuns(workspace, text, bidi::LEVEL_TYPE_DEFAULT_AUTO, runs);
+    ResetAllocationReport();
+
+    AllocationScope scope{};
+    std::vector<bidi::Run> first = bidi::ToRuns(text);
+    std::vector<bidi::Run> second = bidi::ToRuns(text);
+    std::u16string converted = utf::ConvertToUTF16(text);
+    runs.clear();
+    bidi::AppendRuns(workspace, text, bidi::LEVEL_TYPE_DEFAULT_AUTO, runs);
+    AllocationCounts counts = scope.Counts();
+
+    std::vector<ApiAllocations> report = AllocationReport();
+    const ApiAllocations* to_runs = Find(report, "jcu::bidi::ToRuns");
+    const ApiAllocations* append_runs = Find(report, "jcu::bidi::AppendRuns");
+    const ApiAllocations* convert = Find(report, "jcu::utf::ConvertToUTF16");
+    EXPECT_TRUE(to_runs && append_runs && convert);
+    if (!to_runs || !append_runs || !convert) { return; }
+
+    // Calls nested in a tracked call (ToRuns calls AppendRuns) are part of the outer call only.
+    EXPECT_EQ(to_runs->calls, 2);
+    EXPECT_EQ(append_runs->calls, 1);
+    EXPECT_EQ(convert->calls, 1);
+    EXPECT_TRUE(Find(report, "jcu::utf::ConvertToUTF") == nullptr);
+    EXPECT_TRUE(Find(report, "jcu::utf::EncodeUTF16") == nullptr);
+    EXPECT_TRUE(to_runs->allocations.count > 0);
+    EXPECT_EQ(append_runs->allocations.count, 0);
+    EXPECT_EQ(to_runs->allocations.count + convert->allocations.count, counts.count);
+
+    ResetAllocationReport();
+    EXPECT_TRUE(AllocationReport().empty());
+}
@@ -1,5 +1,12 @@
 // Copyright © 2014-2022 Muhammad Tayyab Akram
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -7,6 +14,9 @@
 #include "jcu/bidi/algorithm.hpp"
 #include "jcu/bidi/level.hpp"
 #include "jcu/bidi/runs.hpp"
+#include "jcu/bidi/trace.hpp"
+#include "jcu/bidi/visual.hpp"
+#include "jcu/data/bidi_mirroring.hpp"
 #include "ftest.h"
 
 
@@ -82,3 +92,490 @@ TEST(BidiTests, test_Basic) {
         }
     }
 }
+
+
+TEST(BidiTests, test_IndexMaps) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    {
+        std::u32string_view bidi_text{U"یہ ایک car ہے۔"};
+        std::vector<uint32_t> logical_to_visual(bidi_text.size(), 0);
+        std::vector<uint32_t> visual_to_logical(bidi_text.size(), 0);
+        std::vector<Run> runs = ToRuns(bidi_text, logical_to_visual, visual_to_logical, LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_EQ(runs.size(), 3);
+
+        // Visual order: run 10..13 reversed, run 7..9 as is, run 0..6 reversed.
+        std::vector<uint32_t> expected_v2l{13, 12, 11, 10, 7, 8, 9, 6, 5, 4, 3, 2, 1, 0};
+        EXPECT_TRUE(visual_to_logical == expected_v2l);
+        for (uint32_t visual = 0; visual < visual_to_logical.size(); ++visual) {
+            EXPECT_EQ(logical_to_visual[visual_to_logical[visual]], visual);
+        }
+    }
+
+    {
+        std::u32string_view bidi_text{U"hello"};
+        std::vector<uint32_t> visual_to_logical(bidi_text.size(), 0);
+        ToRuns(bidi_text, {}, visual_to_logical, LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_TRUE((visual_to_logical == std::vector<uint32_t>{0, 1, 2, 3, 4}));
+    }
+
+    {
+        std::u32string_view bidi_text{U"hello"};
+        std::vector<uint32_t> too_small(2, 0);
+        bool thrown = false;
+        try { ToRuns(bidi_text, too_small, {}, LEVEL_TYPE_DEFAULT_AUTO); }
+        catch (const std::out_of_range&) { thrown = true; }
+        EXPECT_TRUE(thrown);
+    }
+}
+
+
+TEST(BidiTests, test_ChainLayouts) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // Long enough to require 32-bit links; each layout must resolve the same runs.
+    std::u32string bidi_text{};
+    for (size_t i = 0; i < 20000; ++i) { bidi_text += U"ab ہے۔ (1)"; }
+
+    std::vector<Run> separate = ToRuns<BidiChainLayout::SEPARATE>(bidi_text, LEVEL_TYPE_DEFAULT_AUTO);
+    std::vector<Run> interleaved = ToRuns<BidiChainLayout::INTERLEAVED>(bidi_text, LEVEL_TYPE_DEFAULT_AUTO);
+    EXPECT_EQ(separate.size(), interleaved.size());
+    for (size_t i = 0; i < separate.size() && i < interleaved.size(); ++i) {
+        EXPECT_EQ(separate[i].offset, interleaved[i].offset);
+        EXPECT_EQ(separate[i].length, interleaved[i].length);
+        EXPECT_EQ(separate[i].level, interleaved[i].level);
+    }
+
+    std::u32string_view short_text{U"یہ ایک car ہے۔"};
+    std::vector<Run> runs = ToRuns<BidiChainLayout::INTERLEAVED>(short_text, LEVEL_TYPE_DEFAULT_AUTO);
+    EXPECT_EQ(runs.size(), 3);
+}
+
+
+TEST(BidiTests, test_FirstStrongIsolate) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // The first strong type of an FSI skips nested isolates.
+    {
+        std::u32string_view bidi_text{U"\u2068\u2067\u05D0\u2069a\u2069"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_LTR);
+        EXPECT_EQ(runs.size(), 5);
+        if (runs.size() == 5) {
+            EXPECT_EQ(runs[3].offset, 3);
+            EXPECT_EQ(runs[3].level, 2);
+        }
+    }
+
+    {
+        std::u32string_view bidi_text{U"\u2068\u2067\u05D0\u2069\u05D1\u2069"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_LTR);
+        EXPECT_EQ(runs.size(), 5);
+        if (runs.size() == 5) {
+            EXPECT_EQ(runs[1].offset, 3);
+            EXPECT_EQ(runs[1].level, 1);
+        }
+    }
+
+    // Deeply nested FSIs are resolved in linear time.
+    {
+        std::u32string bidi_text(50000, U'\u2068');
+        bidi_text += U'\u05D0';
+        bidi_text += std::u32string(50000, U'\u2069');
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_LTR);
+        EXPECT_FALSE(runs.empty());
+    }
+}
+
+
+TEST(BidiTests, test_CodeUnits) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // UTF-8 runs are reported in bytes.
+    {
+        std::u8string_view bidi_text{u8"abc \u05D0\u05D1\u05D2"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_EQ(runs.size(), 2);
+        if (runs.size() == 2) {
+            EXPECT_EQ(runs[0].offset, 0);
+            EXPECT_EQ(runs[0].length, 4);
+            EXPECT_EQ(runs[0].level, 0);
+            EXPECT_EQ(runs[1].offset, 4);
+            EXPECT_EQ(runs[1].length, 6);
+            EXPECT_EQ(runs[1].level, 1);
+        }
+    }
+
+    // A multi-byte common separator between numbers is still a single separator for W4.
+    {
+        std::u8string_view bidi_text{u8"\u05D0" u8"1\u202F2"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_EQ(runs.size(), 2);
+        if (runs.size() == 2) {
+            EXPECT_EQ(runs[0].offset, 2);
+            EXPECT_EQ(runs[0].length, 5);
+            EXPECT_EQ(runs[0].level, 2);
+        }
+    }
+
+    // Trailing bytes after a whitespace or isolate that L1 leaves alone are not reset with the next separator.
+    {
+        std::u8string_view bidi_text{u8"\t\u202D\u2069a"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_RTL);
+        std::ranges::sort(runs, {}, &Run::offset);
+        EXPECT_EQ(runs.size(), 2);
+        if (runs.size() == 2) {
+            EXPECT_EQ(runs[0].offset, 0);
+            EXPECT_EQ(runs[0].length, 4);
+            EXPECT_EQ(runs[0].level, 1);
+            EXPECT_EQ(runs[1].offset, 4);
+            EXPECT_EQ(runs[1].length, 4);
+            EXPECT_EQ(runs[1].level, 2);
+        }
+
+        runs = ToRuns(std::u32string_view{U"\t\u202A\u2069\u00ADa"}, LEVEL_TYPE_RTL);
+        std::ranges::sort(runs, {}, &Run::offset);
+        EXPECT_EQ(runs.size(), 2);
+        if (runs.size() == 2) {
+            EXPECT_EQ(runs[0].length, 2);
+            EXPECT_EQ(runs[0].level, 1);
+            EXPECT_EQ(runs[1].level, 2);
+        }
+    }
+
+    // UTF-16 runs are reported in code units; ill-formed sequences are treated as U+FFFD.
+    {
+        std::u16string bidi_text{u"a\U0001F600\u05D0"};
+        std::vector<Run> runs = ToRuns(bidi_text, LEVEL_TYPE_LTR);
+        EXPECT_EQ(runs.size(), 2);
+        if (runs.size() == 2) {
+            EXPECT_EQ(runs[0].length, 3);
+            EXPECT_EQ(runs[1].offset, 3);
+            EXPECT_EQ(runs[1].level, 1);
+        }
+
+        bidi_text = u"\u05D0";
+        bidi_text += char16_t{0xD800};
+        bidi_text += u"\u05D1";
+        bidi_text += char16_t{0xDC00};
+        bidi_text += u"\u05D2";
+        runs = ToRuns(bidi_text, LEVEL_TYPE_LTR);
+        EXPECT_EQ(runs.size(), 1);
+        if (runs.size() == 1) {
+            EXPECT_EQ(runs[0].length, 5);
+            EXPECT_EQ(runs[0].level, 1);
+        }
+    }
+}
+
+
+TEST(BidiTests, test_Batch) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    std::u32string long_text{};
+    for (size_t i = 0; i < 20000; ++i) { long_text += U"ab ہے۔ (1)"; }
+
+    std::vector<std::u32string_view> labels{U"یہ ایک car ہے۔", U"", U"abc", long_text, U"\u2067ab\u2069 ہے۔",
+                                            U"a (b) ہے"};
+
+    BidiWorkspace workspace{};
+    RunsBatch batch{};
+    for (int pass = 0; pass < 2; ++pass) {
+        ToRunsBatch(labels, workspace, batch, LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_EQ(batch.offsets.size(), labels.size());
+        EXPECT_EQ(batch.counts.size(), labels.size());
+
+        for (size_t i = 0; i < labels.size() && i < batch.offsets.size(); ++i) {
+            std::vector<Run> expected = ToRuns(labels[i], LEVEL_TYPE_DEFAULT_AUTO);
+            EXPECT_EQ(batch.counts[i], expected.size());
+            if (batch.counts[i] != expected.size()) { continue; }
+            for (size_t r = 0; r < expected.size(); ++r) {
+                const Run& run = batch.runs[batch.offsets[i] + r];
+                EXPECT_EQ(run.offset, expected[r].offset);
+                EXPECT_EQ(run.length, expected[r].length);
+                EXPECT_EQ(run.level, expected[r].level);
+            }
+        }
+    }
+
+    RunsBatch single = ToRunsBatch(std::span{labels}.first(1), LEVEL_TYPE_RTL);
+    EXPECT_EQ(single.counts.size(), 1);
+    EXPECT_EQ(single.runs.size(), 3);
+}
+
+
+TEST(BidiTests, test_Parallel) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // Many isolating run sequences of uneven size: isolates, embeddings, overrides, brackets and numbers.
+    std::u32string text{};
+    for (size_t i = 0; i < 4000; ++i) {
+        text += U"{\"k\": \"\u2067ہے (1.5)\u2069\", \u202B[ab 12]\u202C ";
+        if (i % 7 == 0) { text += U"\u2068یہ\u2066a \u202E(x)\u202C 3-4\u2069\u2069 "; }
+        if (i % 13 == 0) { text += U"\u2067\u2067\u2067ا ب\u2069 ("; }
+    }
+
+    for (BidiLevel base_level : {LEVEL_TYPE_LTR, LEVEL_TYPE_RTL, LEVEL_TYPE_DEFAULT_AUTO}) {
+        std::vector<Run> expected = ToRuns(text, base_level);
+        EXPECT_TRUE(ToRunsParallel(text, 1, base_level) == expected);
+        EXPECT_TRUE(ToRunsParallel(text, 3, base_level) == expected);
+        EXPECT_TRUE(ToRunsParallel(text, 0, base_level) == expected);
+        EXPECT_TRUE(ToRunsParallel<BidiChainLayout::INTERLEAVED>(text, 4, base_level) == expected);
+
+        // Short enough for 16-bit links.
+        std::u32string_view head = std::u32string_view{text}.substr(0, 20000);
+        EXPECT_TRUE(ToRunsParallel(head, 4, base_level) == ToRuns(head, base_level));
+    }
+
+    // A reused workspace switches between sequential and parallel resolution.
+    BidiWorkspace workspace{};
+    std::vector<Run> runs{};
+    for (size_t threads : {4, 1, 2}) {
+        workspace.threads = threads;
+        runs.clear();
+        AppendRuns(workspace, text, LEVEL_TYPE_DEFAULT_AUTO, runs);
+        EXPECT_TRUE(runs == ToRuns(text, LEVEL_TYPE_DEFAULT_AUTO));
+    }
+
+    EXPECT_TRUE(ToRunsParallel(std::u32string_view{}, 4).empty());
+}
+
+
+TEST(BidiTests, test_Allocator) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    std::u16string text{};
+    for (size_t i = 0; i < 100; ++i) { text += u"ab \u2067ہے (1.5)\u2069 [یہ 12] "; }
+
+    // Results and working memory all come from the arena; the null upstream throws if it ever runs out.
+    std::vector<std::byte> buffer(4 << 20);
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+    std::pmr::polymorphic_allocator<> allocator{&arena};
+
+    for (BidiLevel base_level : {LEVEL_TYPE_LTR, LEVEL_TYPE_RTL, LEVEL_TYPE_DEFAULT_AUTO}) {
+        std::vector<Run> expected = ToRuns(text, base_level);
+        std::pmr::vector<Run> runs = ToRuns(text, allocator, base_level);
+        EXPECT_TRUE(runs.get_allocator().resource() == &arena);
+        EXPECT_TRUE(std::ranges::equal(runs, expected));
+        EXPECT_TRUE(std::ranges::equal(ToRuns<BidiChainLayout::INTERLEAVED>(text, allocator, base_level), expected));
+        EXPECT_TRUE(std::ranges::equal(ToRunsParallel(text, allocator, 3, base_level), expected));
+    }
+
+    std::vector<std::u16string_view> labels{u"abc", text, u"", u"ہے (1)"};
+    pmr::RunsBatch batch = ToRunsBatch(labels, allocator);
+    EXPECT_TRUE(batch.runs.get_allocator().resource() == &arena);
+    EXPECT_EQ(batch.counts.size(), labels.size());
+    for (size_t i = 0; i < labels.size() && i < batch.counts.size(); ++i) {
+        std::span<const Run> runs = std::span{batch.runs}.subspan(batch.offsets[i], batch.counts[i]);
+        EXPECT_TRUE(std::ranges::equal(runs, ToRuns(labels[i])));
+    }
+
+    // A workspace on the arena with runs of any allocator.
+    BidiWorkspace workspace{&arena};
+    std::vector<Run> runs{};
+    AppendRuns(workspace, text, LEVEL_TYPE_DEFAULT_AUTO, runs);
+    EXPECT_TRUE(runs == ToRuns(text));
+}
+
+TEST(BidiTests, test_Trace) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    std::u32string text{};
+    for (size_t i = 0; i < 500; ++i) { text += U"ab \u2067ہے (1.5)\u2069 [یہ 12] \u202Bx\u202C "; }
+
+    TracedRuns traced = ToRunsTraced(text);
+    const BidiTrace& trace = traced.trace;
+    EXPECT_TRUE(traced.runs == ToRuns(text));
+    EXPECT_EQ(trace[BidiPhase::CLASSIFY].work, text.size());
+    EXPECT_EQ(trace[BidiPhase::PARAGRAPH].calls, 1);
+    EXPECT_EQ(trace[BidiPhase::EXPLICIT].calls, 1);
+    EXPECT_EQ(trace[BidiPhase::REORDER].work, traced.runs.size());
+    EXPECT_TRUE(trace.sequences > 1);
+    for (BidiPhase phase : {BidiPhase::WEAK, BidiPhase::BRACKETS, BidiPhase::NEUTRAL, BidiPhase::IMPLICIT}) {
+        EXPECT_EQ(trace[phase].calls, trace.sequences);
+        EXPECT_TRUE(trace[phase].work > 0);
+    }
+    EXPECT_EQ(trace.brackets, 1000);
+    EXPECT_TRUE(trace.merges > 0);
+    EXPECT_TRUE(trace.run_queue_high_water > 0);
+    EXPECT_EQ(trace.bracket_queue_high_water, 1);
+    EXPECT_TRUE(trace.TotalNanoseconds() > 0);
+
+    // A traced workspace accumulates over paragraphs and threads until reset; the work does not depend on threads.
+    BidiWorkspace<BidiChainLayout::SEPARATE, BidiTrace> workspace{};
+    std::vector<Run> runs{};
+    for (size_t threads : {1, 3}) {
+        workspace.threads = threads;
+        runs.clear();
+        AppendRuns(workspace, text, LEVEL_TYPE_DEFAULT_AUTO, runs);
+        EXPECT_TRUE(runs == traced.runs);
+    }
+    BidiTrace twice = workspace.Trace();
+    EXPECT_EQ(twice.sequences, 2 * trace.sequences);
+    EXPECT_EQ(twice.brackets, 2 * trace.brackets);
+    EXPECT_EQ(twice[BidiPhase::WEAK].work, 2 * trace[BidiPhase::WEAK].work);
+    workspace.ResetTrace();
+    EXPECT_EQ(workspace.Trace().sequences, 0);
+    EXPECT_EQ(workspace.Trace()[BidiPhase::CLASSIFY].calls, 0);
+}
+
+TEST(BidiTests, test_ChainRuns) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // Runs taken from the chain with L1 applied per range match levels per code unit with L1 applied per code unit.
+    std::vector<std::u32string> texts{U"abc \u05D0\u05D1 \t123 \u2067x\u2069  \u200B", U"\u05D0 \u202Ba\u202C\t \u2029",
+                                      U"  \u2066\u05D0 \u2069\u200B \u200B", U"\u0627\u0644 1.5, (b) \u202Ec d\u202C \t"};
+    BidiWorkspace workspace{};
+    for (const std::u32string& text : texts) {
+        std::vector<BidiType> bidi_types(text.size());
+        std::ranges::transform(text, bidi_types.begin(), ClassifyCodePoint);
+        std::vector<char32_t> code_points{text.begin(), text.end()};
+        std::vector<data::BidiBracketTag> bracket_tags(text.size());
+        std::ranges::transform(code_points, bidi_types, bracket_tags.begin(), ClassifyBracket);
+
+        for (BidiLevel base_level : {LEVEL_TYPE_LTR, LEVEL_TYPE_RTL, LEVEL_TYPE_DEFAULT_AUTO}) {
+            std::vector<BidiLevel> levels(text.size());
+            BidiLevel expected_level = ResolveLevels(code_points, bidi_types, base_level, levels);
+            std::vector<Run> expected = ProcessLevels(ResetLevels(bidi_types, levels, expected_level));
+
+            std::vector<Run> runs{};
+            EXPECT_EQ(ResolveRuns(workspace, bracket_tags, bidi_types, base_level, runs), expected_level);
+            EXPECT_TRUE(std::ranges::equal(runs, expected, [](const Run& a, const Run& b) {
+                return a.offset == b.offset && a.length == b.length && a.level == b.level;
+            }));
+        }
+    }
+
+    std::vector<BidiType> bidi_types{BidiType::L, BidiType::WS, BidiType::BN, BidiType::S, BidiType::R, BidiType::WS};
+    std::vector<Run> resets{};
+    FindResetRuns(bidi_types, 1, resets);
+    EXPECT_EQ(resets.size(), 2);
+    if (resets.size() == 2) {
+        EXPECT_EQ(resets[0].offset, 1);
+        EXPECT_EQ(resets[0].length, 3);
+        EXPECT_EQ(resets[1].offset, 5);
+        EXPECT_EQ(resets[1].length, 1);
+        EXPECT_EQ(resets[1].level, 1);
+    }
+}
+
+
+TEST(BidiTests, test_VisualString) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // Right-to-left runs are reversed a code point at a time.
+    EXPECT_TRUE(ToVisualString(std::u8string_view{u8"abc \u05D0\u05D1\u05D2"}) == u8"abc \u05D2\u05D1\u05D0");
+    EXPECT_TRUE(ToVisualString(std::string_view{"abc \u05D0\u05D1"}) == "abc \u05D1\u05D0");
+
+    // Mirrored glyphs at odd levels only (L4).
+    EXPECT_TRUE(ToVisualString(std::u32string_view{U"\u05D0(\u05D1)"}, LEVEL_TYPE_RTL) == U"(\u05D1)\u05D0");
+    EXPECT_TRUE(ToVisualString(std::u32string_view{U"a(b)"}, LEVEL_TYPE_RTL) == U"a(b)");
+    EXPECT_TRUE(ToVisualString(std::u8string_view{u8"\u05D0\u00AB\u05D1\u00BB"}, LEVEL_TYPE_RTL) ==
+                u8"\u00AB\u05D1\u00BB\u05D0");
+
+    // Surrogate pairs stay in order within a reversed run.
+    EXPECT_TRUE(ToVisualString(std::u16string_view{u"\U00010900\u05D0"}) == u"\u05D0\U00010900");
+
+    // Ill-formed sequences within a reversed run are copied as is.
+    std::u8string ill_formed{u8"\u05D0"};
+    ill_formed += char8_t{0xC0};
+    ill_formed += u8"\u05D1";
+    std::u8string ill_formed_visual{u8"\u05D1"};
+    ill_formed_visual += char8_t{0xC0};
+    ill_formed_visual += u8"\u05D0";
+    EXPECT_TRUE(ToVisualString(ill_formed) == ill_formed_visual);
+
+    // Into a caller provided buffer with a reused workspace.
+    std::u32string_view text{U"\u05D0\u05D1 [c]"};
+    std::u32string buffer(text.size(), U'\0');
+    BidiWorkspace workspace{};
+    for (int pass = 0; pass < 2; ++pass) {
+        size_t written = ToVisualString(text, std::span{buffer}, workspace, LEVEL_TYPE_RTL);
+        EXPECT_EQ(written, text.size());
+        EXPECT_TRUE(buffer == U"[c] \u05D1\u05D0");
+    }
+
+    bool thrown = false;
+    std::u32string too_small(2, U'\0');
+    try { ToVisualString(text, std::span{too_small}); }
+    catch (const std::out_of_range&) { thrown = true; }
+    EXPECT_TRUE(thrown);
+
+    // Every mirrored pair is found by the hashed lookup and nothing else is.
+    for (auto it = data::BidiMirroring::begin(); it != data::BidiMirroring::end(); ++it) {
+        EXPECT_TRUE(data::BidiMirroring::Lookup(it->code_point) == it->value);
+    }
+    EXPECT_TRUE(data::BidiMirroring::Lookup(U'a') == 0xFFFFFFFF);
+    EXPECT_TRUE(data::BidiMirroring::Lookup(0xFFFFFFFF) == 0xFFFFFFFF);
+}
+
+
+TEST(BidiTests, test_Reorder) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    {
+        std::vector<Run> runs{
+            {.offset=0, .length=2, .level=0},
+            {.offset=2, .length=1, .level=1},
+            {.offset=3, .length=1, .level=4},
+            {.offset=4, .length=1, .level=4},
+            {.offset=5, .length=1, .level=2},
+            {.offset=6, .length=1, .level=0}
+        };
+        ReorderRuns(runs);
+        std::vector<size_t> offsets{};
+        for (const Run& run : runs) { offsets.push_back(run.offset); }
+        EXPECT_TRUE((offsets == std::vector<size_t>{0, 3, 4, 5, 2, 6}));
+    }
+
+    {
+        std::vector<BidiLevel> levels{0, 0, 1, 4, 4, 2, 0};
+        std::vector<uint32_t> visual_to_logical(levels.size(), 0);
+        ReorderIndices(levels, visual_to_logical);
+        EXPECT_TRUE((visual_to_logical == std::vector<uint32_t>{0, 1, 3, 4, 5, 2, 6}));
+    }
+
+    // Deep nesting; compare against reversing at every level from the highest down to 1.
+    {
+        std::vector<BidiLevel> levels{};
+        for (BidiLevel level = 0; level < 40; ++level) { levels.push_back(level); }
+        for (BidiLevel level = 40; level-- > 3;) { levels.push_back(level); levels.push_back(level); }
+
+        std::vector<uint32_t> expected(levels.size(), 0);
+        for (uint32_t index = 0; index < expected.size(); ++index) { expected[index] = index; }
+        for (BidiLevel level = 39; level > 0; --level) {
+            for (size_t start = 0; start < expected.size();) {
+                if (levels[expected[start]] < level) { ++start; continue; }
+                size_t end = start;
+                while (end < expected.size() && levels[expected[end]] >= level) { ++end; }
+                std::reverse(expected.begin() + start, expected.begin() + end);
+                start = end;
+            }
+        }
+
+        std::vector<uint32_t> visual_to_logical(levels.size(), 0);
+        ReorderIndices(levels, visual_to_logical);
+        EXPECT_TRUE(visual_to_logical == expected);
+
+        std::vector<Run> runs = ProcessLevels(levels);
+        ReorderRuns(runs);
+        std::vector<uint32_t> run_order{};
+        for (const Run& run : runs) {
+            for (size_t i = 0; i < run.length; ++i) {
+                size_t index = (run.level & 1) ? run.offset + run.length - 1 - i : run.offset + i;
+                run_order.push_back(static_cast<uint32_t>(index));
+            }
+        }
+        EXPECT_TRUE(run_order == expected);
+    }
+}
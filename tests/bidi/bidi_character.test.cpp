@@ -1,64 +1,52 @@
 // Copyright © 2024 Jason Stredwick
 
+#include <algorithm>
 #include <filesystem>
 #include <format>
-#include <iostream>
 #include <print>
 #include <string>
-#include <string_view>
 #include <vector>
 
 #include "ftest.h"
 
 #include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/conformance.hpp"
 #include "jcu/bidi/runs.hpp"
-#include "jcu/ucd/bidi_character_test.hpp"
+#include "jcu/parallel.hpp"
 
 
 TEST(BidiTests, test_BidiCharacterTest) {
-    int tests_run = 0;
+    size_t tests_run = 0;
     try {
-        jcu::ucd::BidiCharacterTestForwardView rng{std::filesystem::path{".."} / ".." / "data"};
-
-        auto it = rng.begin();
-        auto end = rng.end();
-        for (int failures = 0; it != end && failures < 10; ++it) {
-            auto [text, levels, order, paragraph_direction, paragraph_level, line_num] = *it;
-            ++tests_run;
-
-            try {
-                auto base_level = jcu::bidi::LEVEL_TYPE_DEFAULT_AUTO;
-                if (paragraph_direction == jcu::ucd::ParagraphDirection::LTR) {
-                    base_level = jcu::bidi::LEVEL_TYPE_LTR;
-                } else if (paragraph_direction == jcu::ucd::ParagraphDirection::RTL) {
-                    base_level = jcu::bidi::LEVEL_TYPE_RTL;
-                }
-
-                std::vector<jcu::bidi::Run> runs = jcu::bidi::ToRuns(text, base_level);
-
-                std::vector<uint8_t> final_levels(text.size(), jcu::bidi::LEVEL_TYPE_INVALID);
-                for (auto& run : runs) {
-                    std::ranges::fill(std::ranges::next(final_levels.begin(), run.offset,              final_levels.end()),
-                                      std::ranges::next(final_levels.begin(), run.offset + run.length, final_levels.end()),
-                                      run.level);
-                }
-
-                bool result = std::ranges::equal(final_levels, levels, [](auto lhs, auto rhs) {
-                    return rhs == 255 || lhs == rhs;
-                });
-                if (!result) {
-                    status = ftest::Failed;
-                    ++failures;
-                    for (auto i : final_levels) { std::print("{} ", i); } std::println("");
-                    for (auto i : levels) { std::print("{} ", i); } std::println("");
-                    std::println("Line {} : Failed", line_num);
-                }
-            } catch (const std::exception& e) {
-                status = ftest::Failed;
-                ++failures;
-                std::println("Line {} : Failed by exception.", line_num);
-                std::println("\n\nException caught:\n{}\n\n", e.what());
+        auto suite = jcu::bidi::BidiConformance::FromBidiCharacterTest(std::filesystem::path{".."} / ".." / "data");
+        auto result = suite.Resolve();
+        tests_run = suite.cases.size();
+
+        // Resolving the isolating run sequences concurrently must not change the result.
+        std::vector<uint8_t> parallel_same(suite.cases.size(), 0);
+        jcu::ParallelFor(suite.cases.size(), result.threads, [&](size_t, size_t index) {
+            auto text = suite.Text(suite.cases[index]);
+            auto base_level = suite.cases[index].base_level;
+            parallel_same[index] =
+                jcu::bidi::ToRuns(text, base_level) == jcu::bidi::ToRunsParallel(text, 4, base_level);
+        });
+
+        for (size_t index = 0, failures = 0; index < suite.cases.size() && failures < 10; ++index) {
+            if (result.passed[index] && parallel_same[index]) { continue; }
+            status = ftest::Failed;
+            ++failures;
+
+            const auto& test = suite.cases[index];
+            if (!result.errors[index].empty()) {
+                std::println("Line {} : Failed by exception.", test.line_num);
+                std::println("\n\nException caught:\n{}\n\n", result.errors[index]);
+                continue;
             }
+            std::vector<uint8_t> final_levels{};
+            suite.Matches(test, jcu::bidi::ToRuns(suite.Text(test), test.base_level), final_levels);
+            for (auto i : final_levels) { std::print("{} ", i); } std::println("");
+            for (auto i : suite.Levels(test)) { std::print("{} ", i); } std::println("");
+            std::println("Line {} : Failed{}", test.line_num, parallel_same[index] ? "" : " (parallel runs differ)");
         }
     } catch (const std::exception& e) {
         status = ftest::Failed;
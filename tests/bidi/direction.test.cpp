@@ -0,0 +1,96 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/direction.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "ftest.h"
+
+
+namespace {
+
+
+/* Direction implied by the paragraph levels the full algorithm picks for either default. */
+jcu::bidi::BaseDirection FullDirection(std::u8string_view text) {
+    using namespace jcu::bidi;
+
+    BidiWorkspace<> workspace{};
+    std::vector<Run> runs{};
+    BidiLevel ltr = AppendRuns(workspace, text, LEVEL_TYPE_DEFAULT_LTR, runs);
+    BidiLevel rtl = AppendRuns(workspace, text, LEVEL_TYPE_DEFAULT_RTL, runs);
+    if (ltr != rtl) { return BaseDirection::NEUTRAL; }
+    return ltr == 0 ? BaseDirection::LTR : BaseDirection::RTL;
+}
+
+
+}
+
+
+TEST(BidiDirectionTests, test_DetectBaseDirection) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    struct Case {
+        std::u8string_view text;
+        BaseDirection expected;
+    };
+    std::vector<Case> cases{
+        {u8"", BaseDirection::NEUTRAL},
+        {u8"hello", BaseDirection::LTR},
+        {u8"שלום", BaseDirection::RTL},
+        {u8"مرحبا", BaseDirection::RTL},
+        {u8"123 - 456", BaseDirection::NEUTRAL},
+        {u8"١٢٣ abc", BaseDirection::LTR},                              // Arabic digits are AN, not strong.
+        {u8"(12) [34] {56} 78.9, +-*/ שלום", BaseDirection::RTL},       // Long ASCII prefix of no strong type.
+        {u8"0123456789012345 x", BaseDirection::LTR},
+        {u8"\u2067שלום\u2069 abc", BaseDirection::LTR},                 // RLI ... PDI is skipped.
+        {u8"\u2066\u2067abc\u2069 xyz\u2069 שלום", BaseDirection::RTL}, // Nested isolates.
+        {u8"\u2068abc", BaseDirection::NEUTRAL},                        // Unmatched FSI skips to the end.
+        {u8"\u202Babc", BaseDirection::LTR},                            // Embeddings are not skipped.
+        {u8"123\nשלום", BaseDirection::NEUTRAL},                        // Only the first paragraph counts.
+        {u8"12345678\u2029abcdefgh", BaseDirection::NEUTRAL},           // U+2029 ends the paragraph.
+        {u8"\u0300\u00A0é", BaseDirection::LTR},                       // Latin beyond ASCII by table.
+    };
+
+    for (const Case& test : cases) {
+        EXPECT_TRUE(DetectBaseDirection(test.text) == test.expected);
+        EXPECT_TRUE(DetectBaseDirection(test.text) == FullDirection(test.text));
+    }
+
+    // Ill-formed UTF-8 is neutral.
+    std::string bytes{"12345678\xC0\xAF\xFF 9 \xD7\x90"};
+    EXPECT_TRUE(DetectBaseDirection(bytes) == BaseDirection::RTL);
+    EXPECT_TRUE(DetectBaseDirection(std::string{"\xE2\x80"}) == BaseDirection::NEUTRAL);
+
+    // UTF-16, UTF-32 and ranges that are not contiguous take the same path a code point at a time.
+    EXPECT_TRUE(DetectBaseDirection(std::u16string{u"12 \u2067a\u2069 \U00010800"}) == BaseDirection::RTL);
+    EXPECT_TRUE(DetectBaseDirection(std::u32string{U"-- z"}) == BaseDirection::LTR);
+    std::u8string text{u8"12345678 12345678 א"};
+    EXPECT_TRUE(DetectBaseDirection(text | std::views::filter([](char8_t) { return true; })) == BaseDirection::RTL);
+}
+
+
+TEST(BidiDirectionTests, test_AsciiWord) {
+    using namespace jcu::bidi::detail;
+
+    auto Word = [](std::string_view bytes) {
+        uint64_t word = 0;
+        for (size_t i = 0; i < 8; ++i) { word |= uint64_t{static_cast<unsigned char>(bytes[i])} << (i * 8); }
+        return ClassifyAsciiWord(word);
+    };
+
+    EXPECT_TRUE(Word("12345678") == AsciiWord::SKIP);
+    EXPECT_TRUE(Word(" !\"#$%&'") == AsciiWord::SKIP);
+    EXPECT_TRUE(Word("@[`{~\x7F" "09") == AsciiWord::SKIP);
+    EXPECT_TRUE(Word("1234567a") == AsciiWord::LETTER);
+    EXPECT_TRUE(Word("A1234567") == AsciiWord::LETTER);
+    EXPECT_TRUE(Word("123Z4567") == AsciiWord::LETTER);
+    EXPECT_TRUE(Word("1234\n567") == AsciiWord::MIXED);
+    EXPECT_TRUE(Word("abc\tdefg") == AsciiWord::MIXED);
+    EXPECT_TRUE(Word("123\xC3\xA9" "456") == AsciiWord::MIXED);
+}
@@ -0,0 +1,93 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/paragraph.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "ftest.h"
+
+
+TEST(BidiParagraphTests, test_Incremental) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // Typing in an RTL paragraph only re-resolves the isolating run sequence being edited.
+    {
+        BidiParagraph paragraph{std::u32string_view{U"یہ ایک \u2066car 12\u2069 ہے۔"}, LEVEL_TYPE_RTL};
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+
+        BidiParagraph::Change change = paragraph.Insert(2, std::u32string_view{U" ک"});
+        EXPECT_FALSE(change.full);
+        EXPECT_FALSE(change.runs.empty());
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+
+        change = paragraph.Insert(11, std::u32string_view{U"s"});
+        EXPECT_FALSE(change.full);
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+
+        change = paragraph.Erase(0, 3);
+        EXPECT_FALSE(change.full);
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+
+        // Adding explicit formatting resolves the whole paragraph.
+        change = paragraph.Insert(1, std::u32string_view{U"\u202B"});
+        EXPECT_TRUE(change.full);
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+    }
+
+    // Changing the first strong character of an automatically determined paragraph level.
+    {
+        BidiParagraph paragraph{std::u32string_view{U"abc ابج"}};
+        EXPECT_EQ(paragraph.ParagraphLevel(), 0);
+        BidiParagraph::Change change = paragraph.Erase(0, 4);
+        EXPECT_TRUE(change.full);
+        EXPECT_EQ(paragraph.ParagraphLevel(), 1);
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints()));
+    }
+
+    // Erasing everything keeps an explicit paragraph level for the text inserted next.
+    {
+        BidiParagraph paragraph{std::u32string_view{U"\u2067"}, LEVEL_TYPE_RTL};
+        paragraph.Erase(0, 1);
+        EXPECT_EQ(paragraph.ParagraphLevel(), 1);
+        paragraph.Insert(0, std::u32string_view{U"abc"});
+        EXPECT_EQ(paragraph.ParagraphLevel(), 1);
+        EXPECT_TRUE(paragraph.Runs() == ToRuns(paragraph.CodePoints(), LEVEL_TYPE_RTL));
+    }
+}
+
+
+TEST(BidiParagraphTests, test_RandomEdits) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    const std::u32string_view pool{U"aZ \u05D0\u05D1 \u0627\u0628 12\u0663 ,.-+$%()[]!\t\u2066\u2067\u2069\u0300"};
+    uint32_t seed = 12345;
+    auto Next = [&seed](uint32_t bound) { seed = seed * 1664525u + 1013904223u; return (seed >> 8) % bound; };
+
+    for (BidiLevel base_level : {LEVEL_TYPE_DEFAULT_AUTO, LEVEL_TYPE_LTR, LEVEL_TYPE_RTL}) {
+        BidiParagraph paragraph{base_level};
+        for (int step = 0; step < 2000; ++step) {
+            size_t size = paragraph.Size();
+            if (size > 0 && Next(3) == 0) {
+                size_t offset = Next(static_cast<uint32_t>(size));
+                size_t count = 1 + Next(static_cast<uint32_t>(std::min<size_t>(size - offset, 4)));
+                paragraph.Erase(offset, count);
+            } else {
+                std::u32string text{};
+                for (uint32_t n = 1 + Next(3); n; --n) { text += pool[Next(static_cast<uint32_t>(pool.size()))]; }
+                paragraph.Insert(Next(static_cast<uint32_t>(size + 1)), text);
+            }
+
+            bool same = paragraph.Runs() == ToRuns(paragraph.CodePoints(), base_level);
+            EXPECT_TRUE(same);
+            if (!same) { break; }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <algorithm>
+#include <cstddef>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/algorithm.hpp"
+#include "jcu/bidi/level.hpp"
+#include "jcu/bidi/runs.hpp"
+#include "jcu/bidi/stream.hpp"
+#include "ftest.h"
+
+
+namespace {
+
+
+struct Collected {
+    std::u8string text{};
+    size_t offset{0};
+    std::vector<jcu::bidi::Run> runs{};
+    jcu::bidi::BidiLevel level{0};
+};
+
+
+template <typename Unit_t>
+auto Collect(std::vector<Collected>& out) {
+    return [&out](const typename jcu::bidi::ParagraphStream<Unit_t>::Paragraph& paragraph) {
+        Collected collected{.offset=paragraph.offset, .runs={paragraph.runs.begin(), paragraph.runs.end()},
+                            .level=paragraph.level};
+        for (Unit_t unit : paragraph.text) { collected.text.push_back(static_cast<char8_t>(unit)); }
+        out.push_back(std::move(collected));
+    };
+}
+
+
+}
+
+
+TEST(BidiStreamTests, test_Paragraphs) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    std::u8string_view text{u8"abc אבג\r\nאבג abc x\u0085\ry (א)"};
+    std::vector<std::u8string_view> expected{u8"abc אבג\r\n", u8"אבג abc ",
+                                             u8"x\u0085", u8"\r", u8"y (א)"};
+
+    std::vector<Collected> whole{};
+    ForEachParagraph(text, Collect<char8_t>(whole));
+    EXPECT_EQ(whole.size(), expected.size());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < whole.size() && i < expected.size(); ++i) {
+        EXPECT_TRUE(whole[i].text == expected[i]);
+        EXPECT_EQ(whole[i].offset, offset);
+        EXPECT_TRUE(whole[i].runs == ToRuns(expected[i]));
+        offset += expected[i].size();
+    }
+    if (whole.size() == expected.size()) {
+        EXPECT_EQ(whole[0].level, 0);
+        EXPECT_EQ(whole[1].level, 1);
+    }
+
+    // Any split of the input into chunks gives the same paragraphs, even through CR LF and multi-byte separators.
+    for (size_t chunk_size = 1; chunk_size <= 8; ++chunk_size) {
+        std::vector<Collected> chunked{};
+        auto on_paragraph = Collect<char8_t>(chunked);
+        ParagraphStream<char8_t> stream{};
+        for (size_t start = 0; start < text.size(); start += chunk_size) {
+            stream.Write(std::span{text}.subspan(start, std::min(chunk_size, text.size() - start)), on_paragraph);
+        }
+        stream.Finish(on_paragraph);
+
+        EXPECT_EQ(chunked.size(), whole.size());
+        for (size_t i = 0; i < chunked.size() && i < whole.size(); ++i) {
+            EXPECT_TRUE(chunked[i].text == whole[i].text);
+            EXPECT_EQ(chunked[i].offset, whole[i].offset);
+            EXPECT_TRUE(chunked[i].runs == whole[i].runs);
+        }
+    }
+}
+
+
+TEST(BidiStreamTests, test_Sources) {
+    using namespace jcu;
+    using namespace jcu::bidi;
+
+    // std::istream of UTF-8.
+    {
+        std::istringstream in{"first\nאב second\nthird"};
+        std::vector<Collected> paragraphs{};
+        ForEachParagraph(in, Collect<char>(paragraphs), LEVEL_TYPE_DEFAULT_AUTO);
+        EXPECT_EQ(paragraphs.size(), 3);
+        if (paragraphs.size() == 3) {
+            EXPECT_EQ(paragraphs[1].offset, 6);
+            EXPECT_EQ(paragraphs[1].level, 1);
+            EXPECT_EQ(paragraphs[2].offset, 18);
+        }
+    }
+
+    // UTF-16 from a range that is not contiguous.
+    {
+        std::u16string text{u"a א\u0085b"};
+        std::vector<Collected> paragraphs{};
+        ForEachParagraph(text | std::views::filter([](char16_t) { return true; }), Collect<char16_t>(paragraphs));
+        EXPECT_EQ(paragraphs.size(), 3);
+        if (paragraphs.size() == 3) {
+            EXPECT_EQ(paragraphs[1].offset, 2);
+            EXPECT_EQ(paragraphs[1].text.size(), 2);
+            EXPECT_EQ(paragraphs[1].level, 1);
+        }
+    }
+}
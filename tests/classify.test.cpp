@@ -0,0 +1,125 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jcu/bidi/bidi_type.hpp"
+#include "jcu/classify.hpp"
+#include "jcu/general_category.hpp"
+#include "jcu/script.hpp"
+#include "ftest.h"
+
+
+TEST(ClassifyTests, test_CodePoints) {
+    using namespace jcu;
+    using bidi::BidiType;
+
+    std::u8string_view text{u8"aא("};
+    std::array<char32_t, 4> code_points{};
+    std::array<BidiType, 4> bidi_types{};
+    std::array<GeneralCategory, 4> general_categories{};
+    std::array<Script, 4> scripts{};
+    std::array<data::BidiBracketsUnit, 4> brackets{};
+
+    size_t count = Classify(text, {.code_points=code_points, .bidi_types=bidi_types,
+                                   .general_categories=general_categories, .scripts=scripts, .brackets=brackets});
+    EXPECT_EQ(count, 3);
+    EXPECT_TRUE(code_points[1] == U'א');
+    EXPECT_TRUE(bidi_types[0] == BidiType::L);
+    EXPECT_TRUE(bidi_types[1] == BidiType::R);
+    EXPECT_TRUE(bidi_types[2] == BidiType::ON);
+    EXPECT_TRUE(general_categories[0] == GeneralCategory::LL);
+    EXPECT_TRUE(general_categories[1] == GeneralCategory::LO);
+    EXPECT_TRUE(general_categories[2] == GeneralCategory::PS);
+    EXPECT_TRUE(scripts[0] == Script::LATN);
+    EXPECT_TRUE(scripts[1] == Script::HEBR);
+    EXPECT_TRUE(scripts[2] == Script::ZYYY);
+    EXPECT_TRUE(brackets[0].bracket_paired_type == data::BracketPairedType::NONE);
+    EXPECT_TRUE(brackets[2].bracket_paired_type == data::BracketPairedType::OPEN);
+    EXPECT_TRUE(brackets[2].paired_code_point == U')');
+
+    // Properties that are not requested are left alone.
+    std::u32string_view text32{U"בגb"};
+    std::array<BidiType, 3> only_bidi{};
+    general_categories.fill(GeneralCategory::NIL);
+    EXPECT_EQ(Classify(text32, {.bidi_types=only_bidi}), 3);
+    EXPECT_TRUE(only_bidi[0] == BidiType::R);
+    EXPECT_TRUE(only_bidi[2] == BidiType::L);
+    EXPECT_TRUE(general_categories[0] == GeneralCategory::NIL);
+}
+
+
+TEST(ClassifyTests, test_CodeUnits) {
+    using namespace jcu;
+    using bidi::BidiType;
+
+    std::u8string_view text{u8"aאb"};
+    std::array<char32_t, 4> code_points{};
+    std::array<BidiType, 4> bidi_types{};
+    std::array<Script, 4> scripts{};
+
+    size_t count = Classify<ClassifyIndex::CODE_UNIT>(text, {.code_points=code_points, .bidi_types=bidi_types,
+                                                             .scripts=scripts});
+    EXPECT_EQ(count, 4);
+    EXPECT_TRUE(code_points[1] == U'א');
+    EXPECT_TRUE(code_points[2] == 0);
+    EXPECT_TRUE(bidi_types[1] == BidiType::R);
+    EXPECT_TRUE(bidi_types[2] == BidiType::BN);
+    EXPECT_TRUE(bidi_types[3] == BidiType::L);
+    EXPECT_TRUE(scripts[2] == Script::HEBR);
+
+    std::u16string_view text16{u"\U0001F600x"};
+    EXPECT_EQ(Classify<ClassifyIndex::CODE_UNIT>(text16, {.code_points=code_points}), 3);
+    EXPECT_TRUE(code_points[0] == U'\U0001F600');
+    EXPECT_TRUE(code_points[1] == 0);
+    EXPECT_TRUE(code_points[2] == U'x');
+}
+
+
+TEST(ClassifyTests, test_Errors) {
+    using namespace jcu;
+    using bidi::BidiType;
+
+    // Ill-formed sequences are U+FFFD, one code unit at a time.
+    std::string text{"a\xE0\x80z"};
+    std::array<char32_t, 4> code_points{};
+    std::array<BidiType, 4> bidi_types{};
+    EXPECT_EQ(Classify(text, {.code_points=code_points, .bidi_types=bidi_types}), 4);
+    EXPECT_TRUE(code_points[1] == U'�');
+    EXPECT_TRUE(code_points[2] == U'�');
+    EXPECT_TRUE(bidi_types[1] == BidiType::ON);
+    EXPECT_TRUE(code_points[3] == U'z');
+
+    bool thrown = false;
+    std::array<BidiType, 2> too_small{};
+    try { Classify(text, {.bidi_types=too_small}); }
+    catch (const std::length_error&) { thrown = true; }
+    EXPECT_TRUE(thrown);
+}
+
+
+TEST(ClassifyTests, test_BracketTags) {
+    using namespace jcu;
+
+    // Both brackets of a pair share a pair ID, as do the canonically equivalent U+2329/U+3008 and U+232A/U+3009.
+    std::u32string_view text{U"(a]\u2329\u3009\u3008\u232A"};
+    std::array<data::BidiBracketTag, 7> tags{};
+    EXPECT_EQ(Classify(text, {.bracket_tags=tags}), 7);
+    EXPECT_TRUE(data::IsBidiBracketTagOpen(tags[0]));
+    EXPECT_EQ(tags[1], 0);
+    EXPECT_TRUE(data::IsBidiBracketTagClose(tags[2]));
+    EXPECT_TRUE(data::BidiBracketTagPairId(tags[0]) != data::BidiBracketTagPairId(tags[2]));
+    EXPECT_TRUE(data::IsBidiBracketTagOpen(tags[3]) && data::IsBidiBracketTagClose(tags[4]));
+    EXPECT_EQ(data::BidiBracketTagPairId(tags[3]), data::BidiBracketTagPairId(tags[4]));
+    EXPECT_EQ(data::BidiBracketTagPairId(tags[5]), data::BidiBracketTagPairId(tags[6]));
+    EXPECT_EQ(data::BidiBracketTagPairId(tags[3]), data::BidiBracketTagPairId(tags[6]));
+
+    // With the bidi classes requested only ON code points are looked up; the tags are the same.
+    std::array<bidi::BidiType, 7> bidi_types{};
+    std::array<data::BidiBracketTag, 7> typed_tags{};
+    Classify(text, {.bidi_types=bidi_types, .bracket_tags=typed_tags});
+    EXPECT_TRUE(tags == typed_tags);
+}
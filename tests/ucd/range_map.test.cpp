@@ -0,0 +1,104 @@
+// Copyright © 2024 Jason Stredwick
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "jcu/constants.hpp"
+#include "jcu/ucd/range_map.hpp"
+#include "ftest.h"
+
+
+namespace {
+
+
+struct Data {
+    char32_t code_point{0};
+    uint8_t value{0};
+};
+
+
+}
+
+
+TEST(RangeMapTests, test_Assign) {
+    using namespace jcu;
+
+    ucd::RangeMap<uint8_t> map{9};
+    map.Assign(0x0000, CODE_POINT_MAX, 1);  // @missing default for everything.
+    map.Assign(0x0600, 0x07BF, 2);          // @missing block default.
+    map.Assign(0x0041, 0x005A, 3);
+    map.Assign(0x0061, 0x007A, 3);
+    map.Assign(0x0700, 0x070F, 1);          // Splits the block default.
+    map.Assign(0x0650, 0x0750, 4);          // Spans the split.
+    map.Assign(CODE_POINT_MAX, CODE_POINT_MAX, 5);
+
+    EXPECT_EQ(map[0x0000], 1);
+    EXPECT_EQ(map[0x0041], 3);
+    EXPECT_EQ(map[0x005B], 1);
+    EXPECT_EQ(map[0x0600], 2);
+    EXPECT_EQ(map[0x064F], 2);
+    EXPECT_EQ(map[0x0700], 4);
+    EXPECT_EQ(map[0x0751], 2);
+    EXPECT_EQ(map[0x07C0], 1);
+    EXPECT_EQ(map[CODE_POINT_MAX], 5);
+
+    auto table = map.ToTable<Data>(0);
+    std::vector<Data> expected{{0x0000, 1}, {0x0041, 3}, {0x005B, 1}, {0x0061, 3}, {0x007B, 1}, {0x0600, 2},
+                               {0x0650, 4}, {0x0751, 2}, {0x07C0, 1}, {CODE_POINT_MAX, 5}, {CODE_POINT_MAX + 1, 0}};
+    EXPECT_EQ(table.size(), expected.size());
+    for (size_t i = 0; i < expected.size() && i < table.size(); ++i) {
+        EXPECT_EQ(table[i].code_point, expected[i].code_point);
+        EXPECT_EQ(table[i].value, expected[i].value);
+    }
+
+    // Untouched code points keep the initial value; equal neighbours are merged.
+    ucd::RangeMap<uint8_t> sparse{0};
+    sparse.Assign(0x10, 0x1F, 7);
+    sparse.Assign(0x20, 0x2F, 7);
+    auto sparse_table = sparse.ToTable<Data>();
+    EXPECT_EQ(sparse_table.size(), 4);
+    EXPECT_EQ(sparse_table[1].code_point, 0x10);
+    EXPECT_EQ(sparse_table[2].code_point, 0x30);
+
+    bool thrown = false;
+    try { map.Assign(0x20, 0x10, 1); }
+    catch (const std::out_of_range&) { thrown = true; }
+    EXPECT_TRUE(thrown);
+
+    thrown = false;
+    try { map.Assign(0x20, CODE_POINT_MAX + 1, 1); }
+    catch (const std::out_of_range&) { thrown = true; }
+    EXPECT_TRUE(thrown);
+}
+
+
+TEST(RangeMapTests, test_MatchesExpansion) {
+    using namespace jcu;
+
+    // Same result as writing every code point of every range into a full array.
+    constexpr char32_t SIZE = 0x400;
+    std::mt19937 rng{43};
+    for (int trial = 0; trial < 200; ++trial) {
+        ucd::RangeMap<uint8_t> map{0};
+        std::vector<uint8_t> all(CODE_POINT_MAX + 1, 0);
+        for (int i = 0; i < 20; ++i) {
+            char32_t first = rng() % SIZE;
+            char32_t last = first + rng() % (SIZE - first);
+            uint8_t value = static_cast<uint8_t>(rng() % 4);
+            map.Assign(first, last, value);
+            for (char32_t cp = first; cp <= last; ++cp) { all[cp] = value; }
+        }
+
+        auto table = map.ToTable<Data>(0);
+        bool same = table.front().code_point == 0 && table.back().code_point == CODE_POINT_MAX + 1;
+        for (size_t i = 0; same && i + 1 < table.size(); ++i) {
+            if (i && table[i - 1].value == table[i].value) { same = false; }
+            for (char32_t cp = table[i].code_point; same && cp < table[i + 1].code_point && cp < SIZE + 1; ++cp) {
+                same = all[cp] == table[i].value && map[cp] == table[i].value;
+            }
+        }
+        EXPECT_TRUE(same);
+    }
+}
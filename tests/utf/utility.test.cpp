@@ -1,5 +1,8 @@
 // Copyright © 2024 Jason Stredwick
 
+#include <array>
+#include <cstddef>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -207,6 +210,35 @@ TEST(UtilityTests, test_Utility_ConvertToUTF) {
 }
 
 
+TEST(UtilityTests, test_Utility_ConvertToUTFAllocator) {
+    using namespace jcu::utf;
+    std::u8string valid1{u8"abcdxyzшницла水手𐌀"};
+    std::u16string valid2{u"abcdxyzшницла水手𐌀"};
+    std::u32string valid3{U"abcdxyzшницла水手𐌀"};
+
+    // Everything fits in the buffer; the null upstream throws if the arena ever needs more.
+    std::array<std::byte, 4096> buffer{};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+    std::pmr::polymorphic_allocator<> allocator{&arena};
+
+    std::pmr::u8string utf8 = ConvertToUTF8(valid3, allocator);
+    std::pmr::u16string utf16 = ConvertToUTF16(valid1, allocator, REPLACEMENT_CHARACTER, true);
+    std::pmr::u32string utf32 = ConvertToUTF32(valid2, allocator);
+    EXPECT_TRUE(std::u8string_view{utf8} == valid1);
+    EXPECT_TRUE(std::u16string_view{utf16} == valid2);
+    EXPECT_TRUE(std::u32string_view{utf32} == valid3);
+    EXPECT_TRUE(utf8.get_allocator().resource() == &arena);
+    EXPECT_TRUE(utf16.get_allocator().resource() == &arena);
+
+    std::u32string invalid{{0x000065e5, 0x00000448, 0x0011ffff}};
+    EXPECT_TRUE(std::u32string_view{ConvertToUTF32(invalid, allocator, U'?')} == U"\u65e5\u0448?");
+
+    std::pmr::u16string attempted{allocator};
+    auto result = AttemptConvertToUTF(valid1, attempted);
+    EXPECT_TRUE(result.error_code == DecodeError::OK);
+    EXPECT_TRUE(std::u16string_view{attempted} == valid2);
+}
+
 TEST(UtilityTests, test_Utility_FindFirstInvalid) {
     using namespace jcu::utf;
     std::string valid0{"abcdxyzшницла水手𐌀"};